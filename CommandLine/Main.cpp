@@ -0,0 +1,242 @@
+#include "../Source/AnalysisCore.h"
+#include "../Source/AnalysisWorker.h"
+#include "../Source/BatchAnalyzer.h"
+#include "../Source/DirectoryIndex.h"
+#include "../Source/LiveScore.h"
+#include <iostream>
+#include <mutex>
+
+//==============================================================================
+//headless batch analyzer, scores a take or every take of a directory against a reference midi file
+//
+//  TimeAnalyzerCLI --reference song.mid --take takes/ --bpm 120 --threshold 20 --output results.txt
+
+namespace
+{
+    const char* usage =
+        "TimeAnalyzerCLI --reference <file.mid> --take <file|dir> [options]\n"
+        "  --bpm <bpm>                 tempo of the reference and takes until the first tempo change of the reference (120)\n"
+        "  --threshold <ms>            max ms from the quantized note to be on time (20)\n"
+        "  --numerator <beats>         beats per measure without time signatures in the reference (4)\n"
+        "  --record-start <measure>    measure of the reference where the takes start (0)\n"
+        "  --one-to-one <ms>           one-to-one alignment with a window in ms instead of closest note matching\n"
+        "  --pitch-groups <groups>     notes matched as the same pitch, e.g. \"42 44 46, 38 40\"\n"
+        "  --detector <amplitude|flux> audio hits from the sample amplitude or the spectral flux (amplitude)\n"
+        "  --db <dB>                   audio hit threshold (0)\n"
+        "  --hit-distance <ms>         min ms between audio hits (50)\n"
+        "  --per-channel               detect audio hits on every channel instead of the peak of all channels\n"
+        "  --per-pitch                 add the statistics of every pitch\n"
+        "  --per-measure               add the statistics of every measure\n"
+        "  --threads <count>           threads that analyze the takes of a directory, or scan a single wav take (number of cpus)\n"
+        "  --save-results              read and write the .tares result file next to every take\n"
+        "  --output <file>             write the results to a file instead of stdout\n"
+        "  --benchmark <notes>         time the midi matcher on random midi and exit\n"
+        "  --benchmark-audio <s|file>  time the audio hit detector on seconds of random audio or a file and exit\n"
+        "  --benchmark-flux <s>        time the spectral flux detector on seconds of random audio and exit\n"
+        "  --benchmark-wav <s|file>    time the memory mapped wav scan on seconds of random audio or a wav file and exit\n"
+        "  --benchmark-peaks <s>       time the waveform peak pyramid on seconds of random audio and exit\n"
+        "  --benchmark-threads <s>     compare and time the wav scan on 1 to 16 threads on seconds of random audio and exit\n"
+        "  --benchmark-live <s>        count torn live score reads on two threads for seconds, time and check the hit cursor and exit\n"
+        "  --benchmark-tempo <changes> time tick and ms conversions on a tempo map with that many tempo changes and exit\n"
+        "  --benchmark-index <takes>   time and check the newest take of a directory index on that many empty takes and exit\n"
+        "  --benchmark-worker <notes>  time 20 analysis requests in a row on a midi take of that many notes, check the last and exit\n"
+        "a benchmark exits with 1 if one of its checks fails\n";
+
+    juce::String getOption(const juce::ArgumentList& args, const char* option, const juce::String& defaultValue = {})
+    {
+        if (!args.containsOption(option))
+            return defaultValue;
+        juce::String value = args.getValueForOption(option);
+        if (value.isEmpty())
+            juce::ConsoleApplication::fail(juce::String("Missing value for ") + option);
+        return value;
+    }
+
+    //prints the report of a benchmark, a failed check fails the command line so a script can catch a regression
+    int printBenchmark(const BenchmarkResult& result)
+    {
+        std::cout << result.report << "\n";
+        if (result.numFailed == 0)
+            return 0;
+
+        std::cerr << "Benchmark failed " << result.numFailed << " checks\n";
+        return 1;
+    }
+
+    void analyze(const juce::ArgumentList& args)
+    {
+        AnalysisSettings settings;
+        settings.bpm = getOption(args, "--bpm", "120").getDoubleValue();
+        settings.msTimeThreshold = getOption(args, "--threshold", "20").getDoubleValue();
+        settings.timeSignatureNumerator = juce::jmax(1, getOption(args, "--numerator", "4").getIntValue());
+        settings.recordBeatStart = getOption(args, "--record-start", "0").getDoubleValue() * settings.timeSignatureNumerator;
+        settings.audioDBThreshold = getOption(args, "--db", "0").getFloatValue();
+        settings.audioHitDistanceMS = getOption(args, "--hit-distance", "50").getIntValue();
+        settings.audioPerChannel = args.containsOption("--per-channel");
+        juce::String detector = getOption(args, "--detector", "amplitude");
+        if (detector == "flux")
+            settings.audioDetector = AnalysisSettings::AudioDetector::spectralFlux;
+        else if (detector != "amplitude")
+            juce::ConsoleApplication::fail("Unknown detector " + detector);
+        if (args.containsOption("--one-to-one"))
+        {
+            settings.oneToOneAlignment = true;
+            settings.msAlignmentWindow = getOption(args, "--one-to-one").getDoubleValue();
+        }
+        if (settings.bpm <= 0)
+            juce::ConsoleApplication::fail("--bpm must be above 0");
+
+        juce::File referenceFile = args.getExistingFileForOption("--reference");
+        juce::MidiFile referenceMidiFile;
+        if (!AnalysisCore::getMidiFile(referenceFile, referenceMidiFile))
+            juce::ConsoleApplication::fail("Can't read midi for " + referenceFile.getFullPathName());
+
+        vArray<MidiEvent> quantizedMidi;
+        AnalysisCore::readMidiFile(referenceMidiFile, settings.bpm, quantizedMidi);
+
+        //tempo and time signature changes of the reference replace --bpm and --numerator after the first change
+        auto tempoMap = std::make_shared<TempoMap>(TempoMap::fromMidiFile(referenceMidiFile, settings.bpm));
+        if (tempoMap->hasChanges())
+        {
+            settings.tempoMap = tempoMap;
+            settings.recordBeatStart = tempoMap->measureToTick(getOption(args, "--record-start", "0").getDoubleValue()) / g_defaultQuarterNoteTicks;
+        }
+
+        juce::File take = args.getExistingFileOrDirectoryForOption("--take");
+        juce::Array<juce::File> takes;
+        if (take.isDirectory())
+            takes = AnalysisCore::findTakes(take);
+        else
+            takes.add(take);
+        if (takes.isEmpty())
+            juce::ConsoleApplication::fail("No takes found in " + take.getFullPathName());
+
+        bool perPitch = args.containsOption("--per-pitch");
+        bool perMeasure = args.containsOption("--per-measure");
+
+        //every take is analyzed on the batch analyzer, the results are written in the order of the takes
+        juce::StringArray results;
+        for (auto& takeFile : takes)
+            results.add(takeFile.getFileName());
+        TimingSummary allTakes;
+        int numFailed = 0;
+        std::mutex resultsMutex;
+
+        //a single take gets the threads for its own wav scan
+        int numThreads = juce::jmax(1, getOption(args, "--threads", juce::String(juce::SystemStats::getNumCpus())).getIntValue());
+        if (takes.size() == 1)
+            settings.audioThreads = numThreads;
+
+        AudioDecoderService decoder(settings.audioThreads);
+        BatchAnalyzer batchAnalyzer(decoder, numThreads);
+        batchAnalyzer.setUseResultFiles(args.containsOption("--save-results"));
+        batchAnalyzer.start(takes, quantizedMidi, MidiMatcher::parsePitchGroups(getOption(args, "--pitch-groups")), settings,
+            [&](int index, const TakeResult& result)
+            {
+                juce::String resultText = result.toString(perPitch, perMeasure);
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                results.set(index, resultText);
+                if (result.wasAnalyzed())
+                    allTakes.merge(result.statistics.total);
+                else
+                    numFailed++;
+            });
+        batchAnalyzer.waitUntilFinished();
+
+        juce::String output = results.joinIntoString("\n") + "\n";
+        if (takes.size() > 1)
+            output += "all takes: " + allTakes.toString() + ", failed: " + juce::String(numFailed) + "\n";
+
+        if (args.containsOption("--output"))
+        {
+            juce::File outputFile = args.getFileForOption("--output");
+            if (!outputFile.replaceWithText(output))
+                juce::ConsoleApplication::fail("Can't write " + outputFile.getFullPathName());
+        }
+        else
+        {
+            std::cout << output;
+        }
+
+        if (numFailed == takes.size())
+            juce::ConsoleApplication::fail("No take could be analyzed", 2);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        if (args.size() == 0 || args.containsOption("--help|-h"))
+        {
+            std::cout << usage;
+            return 0;
+        }
+
+        if (args.containsOption("--benchmark"))
+        {
+            return printBenchmark(MidiMatcher::benchmark(juce::jmax(1, getOption(args, "--benchmark").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-audio"))
+        {
+            juce::String source = getOption(args, "--benchmark-audio");
+            if (source.containsOnly("0123456789"))
+                return printBenchmark(AudioHitDetector::benchmark(juce::jmax(1, source.getIntValue())));
+            return printBenchmark(AudioHitDetector::benchmark(args.getExistingFileForOption("--benchmark-audio"),
+                                                              getOption(args, "--db", "0").getFloatValue(),
+                                                              getOption(args, "--hit-distance", "50").getIntValue()));
+        }
+
+        if (args.containsOption("--benchmark-wav"))
+        {
+            juce::String source = getOption(args, "--benchmark-wav");
+            if (source.containsOnly("0123456789"))
+                return printBenchmark(MappedWavFile::benchmark(juce::jmax(1, source.getIntValue())));
+            return printBenchmark(MappedWavFile::benchmark(args.getExistingFileForOption("--benchmark-wav"),
+                                                           getOption(args, "--db", "0").getFloatValue(),
+                                                           getOption(args, "--hit-distance", "50").getIntValue()));
+        }
+
+        if (args.containsOption("--benchmark-peaks"))
+        {
+            return printBenchmark(PeakPyramid::benchmark(juce::jmax(1, getOption(args, "--benchmark-peaks").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-threads"))
+        {
+            return printBenchmark(MappedWavFile::benchmarkThreads(juce::jmax(1, getOption(args, "--benchmark-threads").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-live"))
+        {
+            return printBenchmark(LiveScore::benchmark(juce::jmax(1, getOption(args, "--benchmark-live").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-tempo"))
+        {
+            return printBenchmark(TempoMap::benchmark(juce::jmax(1, getOption(args, "--benchmark-tempo").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-index"))
+        {
+            return printBenchmark(DirectoryIndex::benchmark(juce::jmax(1, getOption(args, "--benchmark-index").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-worker"))
+        {
+            return printBenchmark(AnalysisWorker::benchmark(juce::jmax(1, getOption(args, "--benchmark-worker").getIntValue())));
+        }
+
+        if (args.containsOption("--benchmark-flux"))
+        {
+            return printBenchmark(SpectralFluxDetector::benchmark(juce::jmax(1, getOption(args, "--benchmark-flux").getIntValue())));
+        }
+
+        analyze(args);
+        return 0;
+    });
+}
@@ -0,0 +1,312 @@
+#include "AnalysisCore.h"
+#include <algorithm>
+
+//==============================================================================
+
+juce::String TakeResult::toString(bool perPitch, bool perMeasure) const
+{
+    juce::String output = take.getFileName() + ": ";
+    if (!wasAnalyzed())
+        return output + error;
+
+    output += statistics.total.toString();
+    output += ", missed: " + juce::String(numMissed) + ", extra: " + juce::String(numExtra);
+
+    if (perPitch)
+    {
+        for (auto& [note, summary] : statistics.byPitch)
+            output += "\n    note " + juce::String(note) + ": " + summary.toString();
+    }
+    if (perMeasure)
+    {
+        for (auto& [measure, summary] : statistics.byMeasure)
+            output += "\n    measure " + juce::String(measure) + ": " + summary.toString();
+    }
+    return output;
+}
+
+//==============================================================================
+
+bool AnalysisCore::getMidiFile(const juce::File& fileOfMidi, juce::MidiFile& out)
+{
+    juce::FileInputStream inputStream(fileOfMidi);
+    if (inputStream.failedToOpen())
+    {
+        return false;
+    }
+    out.clear();
+    if (!out.readFrom(inputStream))
+    {
+        return false;
+    }
+    return true;
+}
+
+void AnalysisCore::readMidiFile(const juce::MidiFile& midiFile, double bpm, vArray<MidiEvent>& out)
+{
+    for (int i = 0; i < midiFile.getNumTracks(); i++)
+    {
+        for (auto sequence : *midiFile.getTrack(i))
+        {
+            if (sequence->message.isNoteOn())
+                out.add(MidiEvent(*sequence, bpm, midiFile.getTimeFormat()));
+        }
+    }
+}
+
+bool AnalysisCore::readAudioFile(AudioDecoderService& decoder, const juce::File& audioFile, const AnalysisSettings& settings, vArray<MidiEvent>& out,
+                                 juce::String& error, const ShouldCancel& shouldCancel, PeakPyramid* peakPyramid)
+{
+    int firstHit = out.size();
+    //uncompressed wav files are scanned in place on their native samples
+    MappedWavFile mappedWavFile;
+    if (settings.audioDetector == AnalysisSettings::AudioDetector::amplitude && mappedWavFile.open(audioFile))
+    {
+        decoder.releaseReader(audioFile);
+        std::vector<std::pair<juce::int64, int>> hits;
+        if (!mappedWavFile.findHits(settings.audioDBThreshold, settings.audioHitDistanceMS, settings.audioPerChannel, hits, shouldCancel,
+                                    decoder.getScanPool(), settings.audioThreads))
+        {
+            error = "Cancelled";
+            return false;
+        }
+        std::vector<double> hitMS;
+        hitMS.reserve(hits.size());
+        for (auto& [sample, channel] : hits)
+        {
+            double ms = sample / mappedWavFile.getSampleRate() * 1000;
+            hitMS.push_back(ms);
+            if (settings.audioPerChannel)
+                out.add(MidiEvent(ms, settings.bpm, true, channel));
+            else
+                out.add(MidiEvent(ms, settings.bpm));
+        }
+        if (settings.tempoMap != nullptr)
+            applyTempoMap(out, firstHit, hitMS, *settings.tempoMap, settings.recordBeatStart);
+        if (peakPyramid != nullptr)
+            mappedWavFile.addPeaks(*peakPyramid);
+        return true;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader = decoder.createReader(audioFile);
+    if (reader == nullptr)
+    {
+        error = "Can't create reader for " + audioFile.getFileName();
+        return false;
+    }
+
+    //only one block of every channel is in memory at a time
+    int numChannels = juce::jmax(1, (int)reader->numChannels);
+    int numDetectors = settings.audioPerChannel ? numChannels : 1;
+    bool spectralFlux = settings.audioDetector == AnalysisSettings::AudioDetector::spectralFlux;
+    juce::OwnedArray<AudioHitDetector> hitDetectors;
+    juce::OwnedArray<SpectralFluxDetector> fluxDetectors;
+    for (int i = 0; i < numDetectors; i++)
+    {
+        if (spectralFlux)
+            fluxDetectors.add(new SpectralFluxDetector(reader->sampleRate, settings.audioDBThreshold, settings.audioHitDistanceMS));
+        else
+            hitDetectors.add(new AudioHitDetector(reader->sampleRate, settings.audioDBThreshold, settings.audioHitDistanceMS));
+    }
+
+    //sample and detector of every hit, merged by time at the end. Per channel the channel is kept as note
+    std::vector<std::pair<double, int>> hits;
+    juce::Array<juce::int64> hitSamples;
+    juce::Array<double> onsetSamples;
+    auto addHits = [&](int detector)
+    {
+        for (juce::int64 sample : hitSamples)
+            hits.push_back({ (double)sample, detector });
+        for (double sample : onsetSamples)
+            hits.push_back({ sample, detector });
+        hitSamples.clearQuick();
+        onsetSamples.clearQuick();
+    };
+
+    if (peakPyramid != nullptr)
+        peakPyramid->reset(reader->sampleRate);
+
+    juce::AudioBuffer<float> block(numChannels, AudioHitDetector::blockSize);
+    for (juce::int64 position = 0; position < reader->lengthInSamples; position += AudioHitDetector::blockSize)
+    {
+        if (shouldCancel && shouldCancel())
+        {
+            error = "Cancelled";
+            return false;
+        }
+
+        int numSamples = (int)juce::jmin<juce::int64>(AudioHitDetector::blockSize, reader->lengthInSamples - position);
+        if (!reader->read(&block, 0, numSamples, position, true, true))
+        {
+            error = "Can't read audio file";
+            return false;
+        }
+
+        for (int detector = 0; detector < numDetectors; detector++)
+        {
+            const float* const* channels = settings.audioPerChannel ? block.getArrayOfReadPointers() + detector : block.getArrayOfReadPointers();
+            int numDetectorChannels = settings.audioPerChannel ? 1 : numChannels;
+            if (spectralFlux)
+                fluxDetectors[detector]->process(channels, numDetectorChannels, numSamples, onsetSamples);
+            else
+                hitDetectors[detector]->process(channels, numDetectorChannels, numSamples, hitSamples);
+            addHits(detector);
+        }
+        if (peakPyramid != nullptr)
+            peakPyramid->addSamples(block.getArrayOfReadPointers(), numChannels, numSamples);
+    }
+    if (peakPyramid != nullptr)
+        peakPyramid->finish();
+    for (int detector = 0; detector < fluxDetectors.size(); detector++)
+    {
+        fluxDetectors[detector]->finish(onsetSamples);
+        addHits(detector);
+    }
+
+    std::sort(hits.begin(), hits.end());
+    std::vector<double> hitMS;
+    hitMS.reserve(hits.size());
+    for (auto& [sample, detector] : hits)
+    {
+        double ms = sample / reader->sampleRate * 1000;
+        hitMS.push_back(ms);
+        if (settings.audioPerChannel)
+            out.add(MidiEvent(ms, settings.bpm, true, detector));
+        else
+            out.add(MidiEvent(ms, settings.bpm));
+    }
+    if (settings.tempoMap != nullptr)
+        applyTempoMap(out, firstHit, hitMS, *settings.tempoMap, settings.recordBeatStart);
+    return true;
+}
+
+void AnalysisCore::applyTempoMap(vArray<MidiEvent>& hits, int start, const std::vector<double>& hitMS, const TempoMap& tempoMap,
+                                 double recordBeatStart)
+{
+    jassert((int)hitMS.size() == hits.size() - start);
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+    double recordMSStart = tempoMap.tickToMS(recordTickStart);
+    std::vector<double> values;
+    values.reserve(hitMS.size());
+    for (double ms : hitMS)
+        values.push_back(recordMSStart + ms);
+
+    //hits of every channel are merged by time, so this is one pass over the tempo changes
+    if (std::is_sorted(values.begin(), values.end()))
+        tempoMap.msToTicks(values.data(), values.data(), (int)values.size());
+    else
+        for (double& value : values)
+            value = tempoMap.msToTick(value);
+
+    for (int i = start; i < hits.size(); i++)
+    {
+        MidiEvent& midi = hits.getReference(i);
+        midi.tickStart = values[(size_t)(i - start)] - recordTickStart;
+        midi.tickEnd = midi.tickStart;
+        midi.quarterNoteTicks = (int)g_defaultQuarterNoteTicks;
+    }
+}
+
+bool AnalysisCore::readTake(AudioDecoderService& decoder, const juce::File& take, const AnalysisSettings& settings, vArray<MidiEvent>& out,
+                            juce::String& error, const ShouldCancel& shouldCancel)
+{
+    if (!take.existsAsFile())
+    {
+        error = "Can't find " + take.getFullPathName();
+        return false;
+    }
+
+    if (isAudioFile(take))
+        return readAudioFile(decoder, take, settings, out, error, shouldCancel);
+
+    juce::MidiFile midiFile;
+    if (!getMidiFile(take, midiFile))
+    {
+        error = "Can't read midi for " + take.getFileName();
+        return false;
+    }
+    readMidiFile(midiFile, settings.bpm, out);
+    return true;
+}
+
+double AnalysisCore::getMSDeviation(const MidiEvent& midi, const MidiEvent& quantizedMidi, double recordBeatStart, double bpm,
+                                    const TempoMap* tempoMap)
+{
+    if (tempoMap != nullptr)
+    {
+        double tick = MidiMatcher::normalizeTick(midi) + recordBeatStart * g_defaultQuarterNoteTicks;
+        return std::round(tempoMap->tickToMS(tick)) - std::round(tempoMap->tickToMS(MidiMatcher::normalizeTick(quantizedMidi)));
+    }
+
+    //relative to record start
+    double tickStart = midi.tickStart + recordBeatStart * midi.quarterNoteTicks;
+    double msStart = MidiEvent::getMiliseconds(tickStart, bpm, midi.quarterNoteTicks);
+    double quantizedMSStart = MidiEvent::getMiliseconds(quantizedMidi.tickStart, bpm, quantizedMidi.quarterNoteTicks);
+    return msStart - quantizedMSStart;
+}
+
+void AnalysisCore::getTimingStatistics(const vArray<MidiEvent>& analyzedMidi, const vArray<MidiEvent>& quantizedMidi,
+                                       const AnalysisSettings& settings, TimingStatistics& out)
+{
+    out.clear();
+    for (const MidiEvent& midi : analyzedMidi)
+    {
+        if (midi.closestQuantizedIndex < 0 || midi.closestQuantizedIndex >= quantizedMidi.size())
+            continue;
+
+        const MidiEvent& quantizedNote = quantizedMidi.getReference(midi.closestQuantizedIndex);
+        double msDifference = getMSDeviation(midi, quantizedNote, settings.recordBeatStart, settings.bpm, settings.tempoMap.get());
+        int measure = settings.tempoMap != nullptr
+            ? (int)std::floor(settings.tempoMap->tickToMeasure(MidiMatcher::normalizeTick(quantizedNote)))
+            : (int)std::floor(quantizedNote.tickStart / quantizedNote.quarterNoteTicks / settings.timeSignatureNumerator);
+        out.add(quantizedNote.note, measure, msDifference, std::abs(msDifference) <= settings.msTimeThreshold);
+    }
+    out.finish();
+}
+
+void AnalysisCore::scoreTake(TakeResult& result, const vArray<MidiEvent>& quantizedMidi, const MidiMatcher& matcher, const AnalysisSettings& settings)
+{
+    if (settings.oneToOneAlignment)
+    {
+        double toleranceTicks = MidiEvent::getTick(settings.msAlignmentWindow, settings.bpm, g_defaultQuarterNoteTicks);
+        MidiMatcher::Alignment alignment = matcher.alignOneToOne(result.analyzedMidi, settings.recordBeatStart, toleranceTicks);
+        result.numMissed = alignment.missedQuantizedIndices.size();
+        result.numExtra = alignment.extraAnalyzedIndices.size();
+    }
+    else
+    {
+        matcher.matchClosest(result.analyzedMidi, settings.recordBeatStart);
+        result.numMissed = 0;
+        result.numExtra = 0;
+        for (const MidiEvent& midi : result.analyzedMidi)
+        {
+            if (midi.closestQuantizedIndex < 0)
+                result.numExtra++;
+        }
+    }
+
+    getTimingStatistics(result.analyzedMidi, quantizedMidi, settings, result.statistics);
+}
+
+TakeResult AnalysisCore::analyzeTake(AudioDecoderService& decoder, const juce::File& take, const vArray<MidiEvent>& quantizedMidi, const MidiMatcher& matcher,
+                                     const AnalysisSettings& settings, const ShouldCancel& shouldCancel)
+{
+    TakeResult result;
+    result.take = take;
+    if (readTake(decoder, take, settings, result.analyzedMidi, result.error, shouldCancel))
+        scoreTake(result, quantizedMidi, matcher, settings);
+    return result;
+}
+
+juce::Array<juce::File> AnalysisCore::findTakes(const juce::File& directory, bool midiTakes, bool audioTakes)
+{
+    juce::Array<juce::File> takes;
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, false, "*", juce::File::findFiles))
+    {
+        const juce::File& file = entry.getFile();
+        if ((midiTakes && isMidiFile(file)) || (audioTakes && isAudioFile(file)))
+            takes.add(file);
+    }
+    takes.sort();
+    return takes;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Globals.h"
+#include "MidiEvent.h"
+#include "MidiMatcher.h"
+#include "TimingStatistics.h"
+#include "AudioHitDetector.h"
+#include "SpectralFluxDetector.h"
+#include "MappedWavFile.h"
+#include "PeakPyramid.h"
+#include "AudioDecoderService.h"
+#include "TempoMap.h"
+
+//==============================================================================
+//everything needed to turn a take into analyzed midi and score it, filled from the editor or the command line
+struct AnalysisSettings
+{
+    double bpm = 120;
+    int timeSignatureNumerator = 4;
+    //absolute beat of the record start
+    double recordBeatStart = 0;
+    //threshold for when a midi note is considered "on time" and not late or early
+    double msTimeThreshold = 20;
+
+    bool oneToOneAlignment = false;
+    double msAlignmentWindow = 100;
+
+    //audio takes
+    enum class AudioDetector
+    {
+        //every sample above audioDBThreshold, see AudioHitDetector
+        amplitude,
+        //onsets of the spectrum of frames above audioDBThreshold, see SpectralFluxDetector
+        spectralFlux
+    };
+    AudioDetector audioDetector = AudioDetector::amplitude;
+    float audioDBThreshold = 0;
+    int audioHitDistanceMS = 50;
+    //detect hits on every channel on its own instead of on the peak of all channels
+    bool audioPerChannel = false;
+    //threads of the scan pool of the decoder that scan one mapped wav take at the same time, the batch analyzer
+    //runs one take per thread instead
+    int audioThreads = 1;
+
+    //tempo and meter changes of the reference, nullptr for bpm and timeSignatureNumerator from the start
+    std::shared_ptr<const TempoMap> tempoMap;
+};
+
+//==============================================================================
+struct TakeResult
+{
+    juce::File take;
+    vArray<MidiEvent> analyzedMidi;
+    TimingStatistics statistics;
+    int numMissed = 0;
+    int numExtra = 0;
+    juce::String error;
+
+    bool wasAnalyzed() const { return error.isEmpty(); }
+    juce::String toString(bool perPitch = false, bool perMeasure = false) const;
+};
+
+//==============================================================================
+//returns true when a long running read should stop, checked between blocks of samples
+typedef std::function<bool()> ShouldCancel;
+
+//==============================================================================
+//file reading and scoring without any ui, shared by the plugin editor and the command line analyzer
+class AnalysisCore
+{
+public:
+    static bool isMidiFile(const juce::File& file) { return file.hasFileExtension(".mid;.midi"); }
+    static bool isAudioFile(const juce::File& file) { return file.hasFileExtension(".wav"); }
+
+    static bool getMidiFile(const juce::File& fileOfMidi, juce::MidiFile& out);
+    //every note on of every track
+    static void readMidiFile(const juce::MidiFile& midiFile, double bpm, vArray<MidiEvent>& out);
+
+    //a hit for every onset of audioDetector that is at least audioHitDistanceMS after the last hit, on all channels or on
+    //every channel with audioPerChannel. The file is streamed through the detector so takes of any length use the same memory,
+    //uncompressed wav files with the amplitude detector are memory mapped and scanned without decoding, see MappedWavFile. Other files are read with the reader of the decoder.
+    //The waveform of the take is built into peakPyramid while it's read
+    static bool readAudioFile(AudioDecoderService& decoder, const juce::File& audioFile, const AnalysisSettings& settings, vArray<MidiEvent>& out,
+                              juce::String& error, const ShouldCancel& shouldCancel = nullptr, PeakPyramid* peakPyramid = nullptr);
+
+    //moves the audio hits from start on to the ticks of the tempo map, hitMS has the ms of each of them from the record start
+    static void applyTempoMap(vArray<MidiEvent>& hits, int start, const std::vector<double>& hitMS, const TempoMap& tempoMap,
+                              double recordBeatStart);
+
+    //reads a .mid or .wav take
+    static bool readTake(AudioDecoderService& decoder, const juce::File& take, const AnalysisSettings& settings, vArray<MidiEvent>& out,
+                         juce::String& error, const ShouldCancel& shouldCancel = nullptr);
+
+    //signed ms that an analyzed hit is off from its quantized note, positive when late. With a tempo map both ticks
+    //are converted through its tempo changes instead of bpm
+    static double getMSDeviation(const MidiEvent& midi, const MidiEvent& quantizedMidi, double recordBeatStart, double bpm,
+                                 const TempoMap* tempoMap = nullptr);
+    //timing of every analyzed hit that has a closestQuantizedIndex
+    static void getTimingStatistics(const vArray<MidiEvent>& analyzedMidi, const vArray<MidiEvent>& quantizedMidi,
+                                    const AnalysisSettings& settings, TimingStatistics& out);
+
+    //matches the analyzed midi of the result and fills in its statistics
+    static void scoreTake(TakeResult& result, const vArray<MidiEvent>& quantizedMidi, const MidiMatcher& matcher, const AnalysisSettings& settings);
+    //reads and scores a take, errors are returned in TakeResult::error
+    static TakeResult analyzeTake(AudioDecoderService& decoder, const juce::File& take, const vArray<MidiEvent>& quantizedMidi, const MidiMatcher& matcher,
+                                  const AnalysisSettings& settings, const ShouldCancel& shouldCancel = nullptr);
+
+    //every .mid/.midi or .wav take of a directory, sorted by name
+    static juce::Array<juce::File> findTakes(const juce::File& directory, bool midiTakes = true, bool audioTakes = true);
+};
@@ -0,0 +1,258 @@
+#include "AnalysisWorker.h"
+#include "TimerBenchmark.h"
+
+//==============================================================================
+
+AnalysisWorker::AnalysisWorker(AudioDecoderService& decoder) : juce::Thread("AnalysisWorker"), m_decoder(decoder)
+{
+    startThread();
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+    cancel();
+    signalThreadShouldExit();
+    notify();
+    stopThread(4000);
+}
+
+juce::uint32 AnalysisWorker::analyze(Request request, TakeAnalyzedCallback takeAnalyzedCallback)
+{
+    auto job = std::make_unique<Job>();
+    job->request = std::move(request);
+    job->takeAnalyzedCallback = std::move(takeAnalyzedCallback);
+
+    juce::uint32 generation;
+    {
+        const juce::ScopedLock scopedLock(m_lock);
+        generation = ++m_generation;
+        job->generation = generation;
+        m_pendingJob = std::move(job);
+        m_busy = true;
+    }
+    notify();
+    return generation;
+}
+
+void AnalysisWorker::cancel()
+{
+    const juce::ScopedLock scopedLock(m_lock);
+    m_pendingJob.reset();
+    ++m_generation;
+}
+
+void AnalysisWorker::run()
+{
+    while (!threadShouldExit())
+    {
+        std::unique_ptr<Job> job;
+        {
+            const juce::ScopedLock scopedLock(m_lock);
+            job = std::move(m_pendingJob);
+            m_busy = job != nullptr;
+        }
+        if (job == nullptr)
+        {
+            wait(-1);
+            continue;
+        }
+
+        std::shared_ptr<AnalyzedTake> analyzedTake = analyzeJob(*job);
+        if (analyzedTake != nullptr && !isStale(job->generation))
+            job->takeAnalyzedCallback(analyzedTake);
+    }
+}
+
+std::shared_ptr<AnalyzedTake> AnalysisWorker::analyzeJob(const Job& job)
+{
+    const Request& request = job.request;
+    const AnalysisSettings& settings = request.settings;
+    juce::uint32 generation = job.generation;
+    ShouldCancel shouldCancel = [this, generation]() { return threadShouldExit() || isStale(generation); };
+    double msStart = juce::Time::getMillisecondCounterHiRes();
+
+    auto analyzedTake = std::make_shared<AnalyzedTake>();
+    analyzedTake->generation = generation;
+    analyzedTake->take = request.take;
+    analyzedTake->recordBeatStart = settings.recordBeatStart;
+    analyzedTake->matchVersion = request.matchVersion;
+    analyzedTake->waveformThresholdGain = juce::Decibels::decibelsToGain(settings.audioDBThreshold);
+
+    TakeResult result;
+    result.take = request.take;
+    if (request.useResultFile)
+    {
+        TakeResultFile resultFile;
+        analyzedTake->readFromResultFile = resultFile.open(TakeResultFile::getResultFile(request.take)) && resultFile.isUpToDate(request.take)
+                                        && resultFile.wasReadWith(settings) && resultFile.readAnalyzedMidi(result.analyzedMidi);
+        if (!analyzedTake->readFromResultFile)
+            result.analyzedMidi.clear();
+    }
+    if (!analyzedTake->readFromResultFile)
+    {
+        if (AnalysisCore::isAudioFile(request.take))
+        {
+            auto waveform = std::make_shared<PeakPyramid>();
+            if (AnalysisCore::readAudioFile(m_decoder, request.take, settings, result.analyzedMidi, result.error, shouldCancel, waveform.get()))
+                analyzedTake->waveform = waveform;
+        }
+        else
+        {
+            AnalysisCore::readTake(m_decoder, request.take, settings, result.analyzedMidi, result.error, shouldCancel);
+        }
+    }
+    if (shouldCancel())
+        return nullptr;
+
+    //the reference buckets are only sorted again after the reference or pitch groups changed
+    if (m_matcherVersion == 0 || m_matcherVersion != request.matchVersion)
+    {
+        m_matcher.setPitchGroups(request.pitchGroups);
+        m_matcher.setReference(request.quantizedMidi);
+        m_matcherVersion = request.matchVersion;
+    }
+    if (settings.oneToOneAlignment)
+    {
+        double toleranceTicks = MidiEvent::getTick(settings.msAlignmentWindow, settings.bpm, g_defaultQuarterNoteTicks);
+        MidiMatcher::Alignment alignment = m_matcher.alignOneToOne(result.analyzedMidi, settings.recordBeatStart, toleranceTicks);
+        analyzedTake->missedQuantizedIndices = alignment.missedQuantizedIndices;
+        result.numMissed = alignment.missedQuantizedIndices.size();
+        result.numExtra = alignment.extraAnalyzedIndices.size();
+    }
+    else
+    {
+        m_matcher.setAnalyzed(result.analyzedMidi, settings.recordBeatStart);
+        for (const MidiEvent& midi : result.analyzedMidi)
+        {
+            if (midi.closestQuantizedIndex < 0)
+                result.numExtra++;
+        }
+    }
+    if (shouldCancel())
+        return nullptr;
+
+    if (request.useResultFile && !analyzedTake->readFromResultFile && result.wasAnalyzed())
+        TakeResultFile::write(TakeResultFile::getResultFile(request.take), result, request.quantizedMidi, settings, analyzedTake->resultFileError);
+
+    analyzedTake->analyzedMidi = std::move(result.analyzedMidi);
+    analyzedTake->matcher = m_matcher;
+    analyzedTake->error = result.error;
+    analyzedTake->msAnalysis = juce::Time::getMillisecondCounterHiRes() - msStart;
+    return analyzedTake;
+}
+
+//==============================================================================
+
+BenchmarkResult AnalysisWorker::benchmark(int numNotes)
+{
+    juce::Random random(numNotes);
+    int quarterNoteTicks = (int)g_defaultQuarterNoteTicks;
+    int sixteenthTicks = quarterNoteTicks / 4;
+
+    //the same random sixteenths as MidiMatcher::benchmark, written as a midi take
+    vArray<MidiEvent> quantizedMidi;
+    juce::MidiMessageSequence sequence;
+    double tick = 0;
+    for (int i = 0; i < numNotes; i++)
+    {
+        tick += sixteenthTicks * (random.nextInt(2) + 1);
+
+        MidiEvent quantized;
+        quantized.note = 36 + random.nextInt(12);
+        quantized.tickStart = tick;
+        quantized.tickEnd = tick;
+        quantizedMidi.add(quantized);
+
+        double hitTick = juce::jmax(0.0, tick + random.nextInt({ -sixteenthTicks, sixteenthTicks }));
+        sequence.addEvent(juce::MidiMessage::noteOn(1, quantized.note, (juce::uint8)100), hitTick);
+        sequence.addEvent(juce::MidiMessage::noteOff(1, quantized.note), hitTick + sixteenthTicks / 2);
+    }
+    sequence.updateMatchedPairs();
+
+    juce::MidiFile midiFile;
+    midiFile.setTicksPerQuarterNote(quarterNoteTicks);
+    midiFile.addTrack(sequence);
+    juce::File take = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("AnalysisWorkerBenchmark.mid");
+    take.deleteFile();
+    {
+        juce::FileOutputStream stream(take);
+        midiFile.writeTo(stream);
+    }
+
+    AudioDecoderService decoder;
+    AnalysisSettings settings;
+    const int numRequests = 20;
+    juce::String output = "AnalysisWorker::benchmark " + juce::String(numNotes) + " notes, " + juce::String(numRequests) + " requests\n";
+
+    //what analyzeFile did on the message thread for every change
+    TimerBench timerBench;
+    MidiMatcher matcher;
+    matcher.setReference(quantizedMidi);
+    vArray<MidiEvent> expectedMidi;
+    for (int i = 0; i < numRequests; i++)
+    {
+        juce::String error;
+        expectedMidi.clear();
+        AnalysisCore::readTake(decoder, take, settings, expectedMidi, error);
+        matcher.setAnalyzed(expectedMidi, settings.recordBeatStart);
+    }
+    output += timerBench.StopAndGetTime("every request on the calling thread (us)") + "\n";
+
+    juce::CriticalSection lock;
+    juce::WaitableEvent takeAnalyzed;
+    std::shared_ptr<const AnalyzedTake> lastTake;
+    int numResults = 0;
+
+    AnalysisWorker worker(decoder);
+    juce::uint32 lastGeneration = 0;
+    timerBench.Start();
+    for (int i = 0; i < numRequests; i++)
+    {
+        Request request;
+        request.take = take;
+        request.quantizedMidi = quantizedMidi;
+        request.settings = settings;
+        request.matchVersion = 1;
+        lastGeneration = worker.analyze(std::move(request), [&](std::shared_ptr<const AnalyzedTake> analyzedTake)
+        {
+            const juce::ScopedLock scopedLock(lock);
+            lastTake = analyzedTake;
+            numResults++;
+            takeAnalyzed.signal();
+        });
+    }
+    output += timerBench.StopAndGetTime("requests on the calling thread (us)") + "\n";
+
+    //fails if the last request doesn't arrive within 10 s of the result before it
+    bool lastArrived = false;
+    while (!lastArrived && takeAnalyzed.wait(10000))
+    {
+        const juce::ScopedLock scopedLock(lock);
+        lastArrived = lastTake != nullptr && lastTake->generation == lastGeneration;
+    }
+    output += timerBench.StopAndGetTime("until the last request was analyzed (us)") + "\n";
+
+    const juce::ScopedLock scopedLock(lock);
+    int mismatches = 0;
+    if (!lastArrived)
+    {
+        output += "the last request timed out\n";
+        mismatches = juce::jmax(1, expectedMidi.size());
+    }
+    else if (lastTake->analyzedMidi.size() != expectedMidi.size())
+    {
+        mismatches = juce::jmax(1, expectedMidi.size());
+    }
+    else
+    {
+        for (int i = 0; i < expectedMidi.size(); i++)
+        {
+            if (lastTake->analyzedMidi[i].closestQuantizedIndex != expectedMidi[i].closestQuantizedIndex)
+                mismatches++;
+        }
+    }
+    output += "results: " + juce::String(numResults) + ", mismatches: " + juce::String(mismatches) + "\n";
+
+    take.deleteFile();
+    return { output, mismatches };
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "AnalysisCore.h"
+#include "TakeResultFile.h"
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+//a take that the AnalysisWorker read and matched, it isn't changed after it was handed to the message thread
+struct AnalyzedTake
+{
+    juce::uint32 generation = 0;
+    juce::File take;
+
+    //matched by matcher at recordBeatStart, the matcher keeps the hits so the record start can be shifted
+    vArray<MidiEvent> analyzedMidi;
+    MidiMatcher matcher;
+    double recordBeatStart = 0;
+    //only in one-to-one alignment mode
+    juce::Array<int> missedQuantizedIndices;
+    //MidiDisplay::getMatchVersion of the request, the display matches again if it changed since
+    juce::uint32 matchVersion = 0;
+
+    //of an audio take that was read, nullptr for midi takes and takes read from their result file
+    std::shared_ptr<const PeakPyramid> waveform;
+    float waveformThresholdGain = 1;
+
+    bool readFromResultFile = false;
+    double msAnalysis = 0;
+    juce::String error;
+    //why the result file couldn't be written, the take was still analyzed
+    juce::String resultFileError;
+};
+
+//==============================================================================
+//reads and matches the take the editor shows on a thread of its own, so the message thread never waits for a take
+//or the matcher. Every request gets the next generation: it replaces the request that is waiting and stops the one
+//that is being read, whose result is dropped, so dragging a setting only finishes the last request
+class AnalysisWorker : private juce::Thread
+{
+public:
+    struct Request
+    {
+        juce::File take;
+        vArray<MidiEvent> quantizedMidi;
+        juce::Array<juce::Array<int>> pitchGroups;
+        AnalysisSettings settings;
+        //MidiDisplay::getMatchVersion when the take was requested, the reference and pitch groups are only set on
+        //the matcher of the worker when it changed
+        juce::uint32 matchVersion = 0;
+        //reads the TakeResultFile of the take if it's up to date, otherwise writes it
+        bool useResultFile = false;
+    };
+
+    //called on the worker thread, never for a request that a newer one replaced
+    typedef std::function<void(std::shared_ptr<const AnalyzedTake> analyzedTake)> TakeAnalyzedCallback;
+
+    //audio takes are opened through the decoder, it has to outlive the worker
+    explicit AnalysisWorker(AudioDecoderService& decoder);
+    ~AnalysisWorker() override;
+
+    //returns the generation of the request
+    juce::uint32 analyze(Request request, TakeAnalyzedCallback takeAnalyzedCallback);
+    //drops the waiting request and stops the one that is being read
+    void cancel();
+
+    //the generation of the newest request, results of every other generation are stale
+    juce::uint32 getGeneration() const { return m_generation; }
+    bool isStale(juce::uint32 generation) const { return generation != m_generation; }
+    //a request is waiting or being analyzed
+    bool isBusy() const { return m_busy; }
+
+    //times requests that follow each other like the changes of a dragged slider against analyzing each of them
+    //on the calling thread, on a midi take of numNotes notes. Every match of the last one that differs fails, and
+    //all of them fail if its result never arrives
+    static BenchmarkResult benchmark(int numNotes);
+
+private:
+    struct Job
+    {
+        Request request;
+        juce::uint32 generation = 0;
+        TakeAnalyzedCallback takeAnalyzedCallback;
+    };
+
+    void run() override;
+    //nullptr if a newer request came in while the take was analyzed
+    std::shared_ptr<AnalyzedTake> analyzeJob(const Job& job);
+
+    AudioDecoderService& m_decoder;
+
+    juce::CriticalSection m_lock;
+    std::unique_ptr<Job> m_pendingJob;
+    std::atomic<juce::uint32> m_generation{ 0 };
+    std::atomic<bool> m_busy{ false };
+
+    //only used on the worker thread
+    MidiMatcher m_matcher;
+    //0 until the reference was set
+    juce::uint32 m_matcherVersion = 0;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisWorker)
+};
@@ -0,0 +1,110 @@
+#include "AudioDecoderService.h"
+
+//==============================================================================
+
+AudioDecoderService::AudioDecoderService(int numScanThreads)
+    : m_numScanThreads(juce::jmax(1, numScanThreads))
+{
+    m_formatManager.registerBasicFormats();
+}
+
+AudioDecoderService::FileInfo AudioDecoderService::getFileInfo(const juce::File& audioFile)
+{
+    juce::int64 fileSize = audioFile.getSize();
+    juce::Time modificationTime = audioFile.getLastModificationTime();
+    {
+        const juce::ScopedLock scopedLock(m_lock);
+        auto cached = m_fileInfos.find(audioFile.getFullPathName());
+        if (cached != m_fileInfos.end() && cached->second.fileSize == fileSize && cached->second.modificationTime == modificationTime)
+            return cached->second;
+    }
+
+    FileInfo info;
+    std::unique_ptr<juce::AudioFormatReader> reader = openReader(audioFile, info);
+
+    const juce::ScopedLock scopedLock(m_lock);
+    if (reader != nullptr)
+    {
+        m_keptFile = audioFile;
+        m_keptReader = std::move(reader);
+    }
+    return info;
+}
+
+bool AudioDecoderService::canReadAudioFile(const juce::File& audioFile, juce::String& error)
+{
+    FileInfo info = getFileInfo(audioFile);
+    if (!info.canRead())
+    {
+        error = info.error;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<juce::AudioFormatReader> AudioDecoderService::createReader(const juce::File& audioFile)
+{
+    {
+        const juce::ScopedLock scopedLock(m_lock);
+        if (m_keptReader != nullptr && m_keptFile == audioFile)
+        {
+            //the file could have been written again since it was checked
+            auto cached = m_fileInfos.find(audioFile.getFullPathName());
+            std::unique_ptr<juce::AudioFormatReader> reader = std::move(m_keptReader);
+            m_keptFile = juce::File();
+            if (cached != m_fileInfos.end() && cached->second.fileSize == audioFile.getSize()
+                && cached->second.modificationTime == audioFile.getLastModificationTime())
+                return reader;
+        }
+    }
+
+    FileInfo info;
+    return openReader(audioFile, info);
+}
+
+void AudioDecoderService::releaseReader(const juce::File& audioFile)
+{
+    const juce::ScopedLock scopedLock(m_lock);
+    if (m_keptFile == audioFile)
+    {
+        m_keptReader = nullptr;
+        m_keptFile = juce::File();
+    }
+}
+
+std::unique_ptr<juce::AudioFormatReader> AudioDecoderService::openReader(const juce::File& audioFile, FileInfo& info)
+{
+    info.fileSize = audioFile.getSize();
+    info.modificationTime = audioFile.getLastModificationTime();
+    std::unique_ptr<juce::AudioFormatReader> reader(m_formatManager.createReaderFor(audioFile));
+    if (reader == nullptr || reader->sampleRate <= 0)
+    {
+        reader = nullptr;
+        info.error = "Can't create reader for " + audioFile.getFileName();
+    }
+    else
+    {
+        info.formatName = reader->getFormatName();
+        info.sampleRate = reader->sampleRate;
+        info.numChannels = (int)reader->numChannels;
+        info.lengthInSamples = reader->lengthInSamples;
+    }
+
+    //every open updates the cache so the next poll of the file doesn't open it again
+    const juce::ScopedLock scopedLock(m_lock);
+    if ((int)m_fileInfos.size() >= maxCachedFiles)
+        m_fileInfos.clear();
+    m_fileInfos[audioFile.getFullPathName()] = info;
+    return reader;
+}
+
+juce::ThreadPool* AudioDecoderService::getScanPool()
+{
+    if (m_numScanThreads <= 1)
+        return nullptr;
+
+    const juce::ScopedLock scopedLock(m_lock);
+    if (m_scanPool == nullptr)
+        m_scanPool = std::make_unique<juce::ThreadPool>(m_numScanThreads);
+    return m_scanPool.get();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Globals.h"
+#include <map>
+
+//==============================================================================
+//one format manager for every audio take that is polled or analyzed. The header of a take is only read again when
+//its size or modification time changed, and the reader that checked a take is handed to the analysis of that take
+//so a new take is opened once. Safe to use from the batch threads
+class AudioDecoderService
+{
+public:
+    //what the header of an audio file says, error is empty when it can be read
+    struct FileInfo
+    {
+        juce::int64 fileSize = -1;
+        juce::Time modificationTime;
+
+        juce::String formatName;
+        double sampleRate = 0;
+        int numChannels = 0;
+        juce::int64 lengthInSamples = 0;
+        juce::String error;
+
+        bool canRead() const { return error.isEmpty(); }
+    };
+
+    //numScanThreads is the size of the pool that scans one mapped wav take, 1 scans on the calling thread
+    AudioDecoderService(int numScanThreads = 1);
+
+    //from the cache while the file is unchanged, otherwise the file is opened and its reader is kept for createReader
+    FileInfo getFileInfo(const juce::File& audioFile);
+    bool canReadAudioFile(const juce::File& audioFile, juce::String& error);
+
+    //the reader kept by getFileInfo if it was for this file, otherwise a new reader. nullptr if the file can't be read
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& audioFile);
+    //closes the kept reader of the file, for when the take was read without it
+    void releaseReader(const juce::File& audioFile);
+
+    juce::AudioFormatManager& getFormatManager() { return m_formatManager; }
+
+    //the pool is created on the first scan and kept, nullptr for one scan thread
+    juce::ThreadPool* getScanPool();
+    int getNumScanThreads() const { return m_numScanThreads; }
+    //leaves a core for the audio thread of the host and doesn't take every core of a big machine
+    static int getDefaultScanThreads() { return juce::jlimit(1, maxScanThreads, juce::SystemStats::getNumCpus() - 1); }
+    inline static const int maxScanThreads = 8;
+
+    //files whose header is cached before the cache is cleared
+    inline static const int maxCachedFiles = 1024;
+
+private:
+    //opens the file and caches its header
+    std::unique_ptr<juce::AudioFormatReader> openReader(const juce::File& audioFile, FileInfo& info);
+
+    //only read after the constructor so createReaderFor can be called from any thread
+    juce::AudioFormatManager m_formatManager;
+
+    juce::CriticalSection m_lock;
+    std::map<juce::String, FileInfo> m_fileInfos;
+    //the reader opened by the last getFileInfo that had to open its file
+    juce::File m_keptFile;
+    std::unique_ptr<juce::AudioFormatReader> m_keptReader;
+
+    const int m_numScanThreads;
+    std::unique_ptr<juce::ThreadPool> m_scanPool;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioDecoderService)
+};
@@ -0,0 +1,186 @@
+#include "AudioHitDetector.h"
+#include <limits>
+
+namespace
+{
+    juce::int64 toHitDistanceSamples(double sampleRate, int hitDistanceMS) { return (juce::int64)(sampleRate * (hitDistanceMS / 1000.f)); }
+}
+
+//==============================================================================
+
+AudioHitDetector::AudioHitDetector(double sampleRate, float dBThreshold, int hitDistanceMS)
+    : m_sampleRate(sampleRate)
+{
+    setThreshold(dBThreshold, hitDistanceMS);
+}
+
+void AudioHitDetector::setThreshold(float dBThreshold, int hitDistanceMS)
+{
+    //gainToDecibels clamps at -100 dB so that is the lowest threshold
+    m_thresholdGain = std::pow(10.f, juce::jmax(dBThreshold, -100.f) * 0.05f);
+    m_hitDistanceSamples = toHitDistanceSamples(m_sampleRate, hitDistanceMS);
+}
+
+void AudioHitDetector::prepare()
+{
+    if (m_envelope == nullptr)
+    {
+        m_envelope.allocate(blockSize, false);
+        m_absoluteChannel.allocate(blockSize, false);
+    }
+}
+
+void AudioHitDetector::reset()
+{
+    m_samplePosition = 0;
+    m_lastHitSample = -1;
+}
+
+void AudioHitDetector::process(const float* samples, int numSamples, juce::Array<juce::int64>& hitSamples)
+{
+    //the samples within the hit distance of the last hit can't be a hit so they are never looked at
+    juce::int64 start = 0;
+    if (m_lastHitSample >= 0)
+        start = juce::jmax<juce::int64>(0, m_lastHitSample + m_hitDistanceSamples + 1 - m_samplePosition);
+
+    while (start < numSamples)
+    {
+        int hit = findFirstHit(samples + start, numSamples - (int)start);
+        if (hit < 0)
+            break;
+
+        m_lastHitSample = m_samplePosition + start + hit;
+        hitSamples.add(m_lastHitSample);
+        start += hit + m_hitDistanceSamples + 1;
+    }
+    m_samplePosition += numSamples;
+}
+
+void AudioHitDetector::process(const float* const* channels, int numChannels, int numSamples, juce::Array<juce::int64>& hitSamples)
+{
+    if (numChannels == 1)
+    {
+        process(channels[0], numSamples, hitSamples);
+        return;
+    }
+
+    prepare();
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        int blockLength = juce::jmin(blockSize, numSamples - start);
+        juce::FloatVectorOperations::abs(m_envelope, channels[0] + start, blockLength);
+        for (int channel = 1; channel < numChannels; channel++)
+        {
+            juce::FloatVectorOperations::abs(m_absoluteChannel, channels[channel] + start, blockLength);
+            juce::FloatVectorOperations::max(m_envelope, m_envelope, m_absoluteChannel, blockLength);
+        }
+        process(m_envelope, blockLength, hitSamples);
+    }
+}
+
+int AudioHitDetector::findFirstHit(const float* samples, int numSamples) const
+{
+    for (int blockStart = 0; blockStart < numSamples; blockStart += scanBlockSize)
+    {
+        int blockLength = juce::jmin(scanBlockSize, numSamples - blockStart);
+
+        //vectorized, most of a take is below the threshold and is skipped here
+        juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax(samples + blockStart, blockLength);
+        if (range.getEnd() <= m_thresholdGain && -range.getStart() <= m_thresholdGain)
+            continue;
+
+        for (int i = blockStart; i < blockStart + blockLength; i++)
+        {
+            if (std::abs(samples[i]) > m_thresholdGain)
+                return i;
+        }
+    }
+    return -1;
+}
+
+//==============================================================================
+
+void AudioHitDetector::processBruteForce(const float* samples, int numSamples, double sampleRate, float dBThreshold, int hitDistanceMS,
+                                         juce::Array<juce::int64>& hitSamples, bool signedSamples)
+{
+    juce::int64 hitDistanceSamples = toHitDistanceSamples(sampleRate, hitDistanceMS);
+    juce::int64 samplesSinceLastHit = 0;
+    bool hasHit = false;
+    for (int sample = 0; sample < numSamples; sample++)
+    {
+        float gain = signedSamples ? samples[sample] : std::abs(samples[sample]);
+        float dBVolume = juce::Decibels::gainToDecibels<float>(gain);
+        if (dBVolume > dBThreshold && (samplesSinceLastHit > hitDistanceSamples || !hasHit))
+        {
+            hitSamples.add(sample);
+            samplesSinceLastHit = 0;
+            hasHit = true;
+        }
+        samplesSinceLastHit++;
+    }
+}
+
+BenchmarkResult AudioHitDetector::benchmark(int numSeconds)
+{
+    double sampleRate = 48000;
+    int numSamples = (int)(numSeconds * sampleRate);
+    juce::Random random(numSeconds);
+
+    //quiet noise with a decaying hit of either polarity every 100 to 400 ms
+    juce::HeapBlock<float> samples(numSamples);
+    BenchmarkHits hits;
+    hits.sampleRate = sampleRate;
+    hits.generate(samples, numSamples, random);
+
+    BenchmarkResult result = benchmark(samples, numSamples, sampleRate, -20, 50);
+    result.report = "AudioHitDetector::benchmark " + juce::String(numSeconds) + " s of random hits\n" + result.report;
+    return result;
+}
+
+BenchmarkResult AudioHitDetector::benchmark(const juce::File& audioFile, float dBThreshold, int hitDistanceMS)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+    if (reader == nullptr || reader->lengthInSamples > std::numeric_limits<int>::max())
+        return { "Can't read " + audioFile.getFileName() + "\n", 1 };
+
+    juce::AudioBuffer<float> audioBuffer(1, (int)reader->lengthInSamples);
+    if (!reader->read(&audioBuffer, 0, audioBuffer.getNumSamples(), 0, true, false))
+        return { "Can't read " + audioFile.getFileName() + "\n", 1 };
+
+    BenchmarkResult result = benchmark(audioBuffer.getReadPointer(0), audioBuffer.getNumSamples(), reader->sampleRate,
+                                       dBThreshold, hitDistanceMS);
+    result.report = "AudioHitDetector::benchmark " + audioFile.getFileName() + "\n" + result.report;
+    return result;
+}
+
+BenchmarkResult AudioHitDetector::benchmark(const float* samples, int numSamples, double sampleRate, float dBThreshold, int hitDistanceMS)
+{
+    juce::String output;
+
+    TimerBench timerBench;
+    juce::Array<juce::int64> hits;
+    AudioHitDetector hitDetector(sampleRate, dBThreshold, hitDistanceMS);
+    for (int start = 0; start < numSamples; start += blockSize)
+        hitDetector.process(samples + start, juce::jmin(blockSize, numSamples - start), hits);
+    output += timerBench.StopAndGetTime("process (us)") + "\n";
+
+    timerBench.Start();
+    juce::Array<juce::int64> bruteForceHits;
+    processBruteForce(samples, numSamples, sampleRate, dBThreshold, hitDistanceMS, bruteForceHits);
+    output += timerBench.StopAndGetTime("processBruteForce (us)") + "\n";
+
+    juce::Array<juce::int64> signedHits;
+    processBruteForce(samples, numSamples, sampleRate, dBThreshold, hitDistanceMS, signedHits, true);
+
+    int mismatches = std::abs(hits.size() - bruteForceHits.size());
+    for (int i = 0; i < juce::jmin(hits.size(), bruteForceHits.size()); i++)
+    {
+        if (hits[i] != bruteForceHits[i])
+            mismatches++;
+    }
+    output += "hits: " + juce::String(hits.size()) + ", hits without negative samples: " + juce::String(signedHits.size()) + "\n";
+    output += "mismatches: " + juce::String(mismatches) + "\n";
+    return { output, mismatches };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Globals.h"
+
+//==============================================================================
+//finds hits in audio that is passed in one block at a time, the distance to the last hit is kept between
+//blocks so a take can be streamed through a fixed size buffer no matter how long it is
+class AudioHitDetector
+{
+public:
+    AudioHitDetector(double sampleRate, float dBThreshold, int hitDistanceMS);
+
+    //forgets the last hit and starts again at sample 0
+    void reset();
+    //allocates the buffers of multi channel blocks up front so process never allocates, for the audio thread
+    void prepare();
+    //changes the threshold and hit distance without forgetting the last hit
+    void setThreshold(float dBThreshold, int hitDistanceMS);
+
+    //adds the absolute sample position of every hit in the block, the blocks have to be passed in order.
+    //A hit is a sample whose absolute value is above the threshold gain and more than the hit distance after the last hit
+    void process(const float* samples, int numSamples, juce::Array<juce::int64>& hitSamples);
+    //process on the peak envelope of the channels, the largest absolute value of every sample across the channels
+    void process(const float* const* channels, int numChannels, int numSamples, juce::Array<juce::int64>& hitSamples);
+
+    juce::int64 getSamplePosition() const { return m_samplePosition; }
+    double getSampleRate() const { return m_sampleRate; }
+    float getThresholdGain() const { return m_thresholdGain; }
+    juce::int64 getHitDistanceSamples() const { return m_hitDistanceSamples; }
+
+    //samples read from the file at a time
+    inline static const int blockSize = 1 << 16;
+    //samples whose min and max are checked at once before they are scanned one by one
+    inline static const int scanBlockSize = 256;
+
+    //the per sample gainToDecibels loop that the detector replaced, signedSamples keeps its old bug
+    //where negative samples were never a hit
+    static void processBruteForce(const float* samples, int numSamples, double sampleRate, float dBThreshold, int hitDistanceMS,
+                                  juce::Array<juce::int64>& hitSamples, bool signedSamples = false);
+
+    //times process against processBruteForce on random drum like audio or on the first channel of an audio file,
+    //every hit where they disagree fails
+    static BenchmarkResult benchmark(int numSeconds);
+    static BenchmarkResult benchmark(const juce::File& audioFile, float dBThreshold, int hitDistanceMS);
+
+private:
+    //position of the first sample above the threshold or -1
+    int findFirstHit(const float* samples, int numSamples) const;
+
+    static BenchmarkResult benchmark(const float* samples, int numSamples, double sampleRate, float dBThreshold, int hitDistanceMS);
+
+    //holds blockSize samples, allocated on the first multi channel block
+    juce::HeapBlock<float> m_envelope;
+    juce::HeapBlock<float> m_absoluteChannel;
+
+    double m_sampleRate;
+    float m_thresholdGain;
+    juce::int64 m_hitDistanceSamples;
+
+    juce::int64 m_samplePosition = 0;
+    //-1 before the first hit
+    juce::int64 m_lastHitSample = -1;
+
+private:
+    JUCE_LEAK_DETECTOR(AudioHitDetector)
+};
@@ -0,0 +1,77 @@
+#include "BatchAnalyzer.h"
+
+//==============================================================================
+
+BatchAnalyzer::BatchAnalyzer(AudioDecoderService& decoder, int numThreads)
+    : m_decoder(decoder), m_pool(juce::jmax(1, numThreads))
+{
+}
+
+BatchAnalyzer::~BatchAnalyzer()
+{
+    cancel();
+}
+
+void BatchAnalyzer::start(const juce::Array<juce::File>& takes, const vArray<MidiEvent>& quantizedMidi,
+                          const juce::Array<juce::Array<int>>& pitchGroups, const AnalysisSettings& settings,
+                          TakeFinishedCallback takeFinishedCallback)
+{
+    cancel();
+    if (takes.isEmpty())
+        return;
+
+    auto batch = std::make_shared<Batch>();
+    batch->decoder = &m_decoder;
+    batch->quantizedMidi = quantizedMidi;
+    batch->matcher.setPitchGroups(pitchGroups);
+    batch->matcher.setReference(quantizedMidi);
+    batch->settings = settings;
+    //the takes already run on every thread of the pool
+    batch->settings.audioThreads = 1;
+    batch->takeFinishedCallback = std::move(takeFinishedCallback);
+    batch->useResultFiles = m_useResultFiles;
+    batch->remaining = takes.size();
+    batch->finished.reset();
+    m_batch = batch;
+
+    for (int i = 0; i < takes.size(); i++)
+        m_pool.addJob(new TakeJob(batch, takes[i], i), true);
+}
+
+void BatchAnalyzer::cancel()
+{
+    if (m_batch == nullptr)
+        return;
+
+    m_batch->cancelled = true;
+    //jobs that are running see the flag, the rest are removed before they start. A job that is still running keeps
+    //its batch alive and only calls back if it wasn't cancelled, and a caller drops results of an older batch anyway
+    m_pool.removeAllJobs(true, msCancelTimeout);
+    m_batch->finished.signal();
+    m_batch = nullptr;
+}
+
+bool BatchAnalyzer::waitUntilFinished(int msTimeout)
+{
+    if (m_batch == nullptr)
+        return true;
+    return m_batch->finished.wait(msTimeout);
+}
+
+juce::ThreadPoolJob::JobStatus BatchAnalyzer::TakeJob::runJob()
+{
+    Batch& batch = *m_batch;
+    auto shouldCancel = [this, &batch]() { return batch.cancelled || shouldExit(); };
+    if (shouldCancel())
+        return jobHasFinished;
+
+    TakeResult result = batch.useResultFiles
+                        ? TakeResultFile::analyzeTake(*batch.decoder, m_take, batch.quantizedMidi, batch.matcher, batch.settings, shouldCancel)
+                        : AnalysisCore::analyzeTake(*batch.decoder, m_take, batch.quantizedMidi, batch.matcher, batch.settings, shouldCancel);
+    if (!shouldCancel() && batch.takeFinishedCallback)
+        batch.takeFinishedCallback(m_index, result);
+
+    if (--batch.remaining == 0)
+        batch.finished.signal();
+    return jobHasFinished;
+}
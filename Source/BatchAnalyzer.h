@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AnalysisCore.h"
+#include "TakeResultFile.h"
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+//analyzes every take of a batch against the same reference on a thread pool, one job per take so the
+//idle threads keep taking the next take from the queue until the batch is done or cancelled
+class BatchAnalyzer
+{
+public:
+    //called on the thread that analyzed the take, index is the position of the take in the batch
+    typedef std::function<void(int index, const TakeResult& result)> TakeFinishedCallback;
+
+    //audio takes are opened through the decoder, it has to outlive the analyzer
+    BatchAnalyzer(AudioDecoderService& decoder, int numThreads = juce::SystemStats::getNumCpus());
+    ~BatchAnalyzer();
+
+    //cancels the running batch and starts a new one, the reference and settings are copied
+    void start(const juce::Array<juce::File>& takes, const vArray<MidiEvent>& quantizedMidi,
+               const juce::Array<juce::Array<int>>& pitchGroups, const AnalysisSettings& settings,
+               TakeFinishedCallback takeFinishedCallback);
+    //stops the running batch, takes that haven't started are dropped and a take that is being read stops early.
+    //Waits at most msCancelTimeout for the running takes, a take that is still running then finishes on its own
+    //without calling back
+    void cancel();
+    inline static const int msCancelTimeout = 200;
+
+    bool isRunning() const { return m_batch != nullptr && !m_batch->finished.wait(0); }
+    //waits for the running batch, returns false if it didn't finish within msTimeout (-1 waits forever)
+    bool waitUntilFinished(int msTimeout = -1);
+
+    int getNumThreads() const { return m_pool.getNumThreads(); }
+
+    //takes of the next batch are read from and written to their TakeResultFile
+    void setUseResultFiles(bool useResultFiles) { m_useResultFiles = useResultFiles; }
+
+private:
+    //shared by the jobs of one batch, immutable except for the counters
+    struct Batch
+    {
+        AudioDecoderService* decoder = nullptr;
+        vArray<MidiEvent> quantizedMidi;
+        MidiMatcher matcher;
+        AnalysisSettings settings;
+        TakeFinishedCallback takeFinishedCallback;
+        bool useResultFiles = false;
+
+        std::atomic<bool> cancelled{ false };
+        std::atomic<int> remaining{ 0 };
+        juce::WaitableEvent finished{ true };
+    };
+
+    class TakeJob : public juce::ThreadPoolJob
+    {
+    public:
+        TakeJob(std::shared_ptr<Batch> batch, const juce::File& take, int index)
+            : juce::ThreadPoolJob("TakeJob " + take.getFileName()), m_batch(std::move(batch)), m_take(take), m_index(index) {}
+
+        JobStatus runJob() override;
+
+    private:
+        std::shared_ptr<Batch> m_batch;
+        juce::File m_take;
+        int m_index;
+    };
+
+    AudioDecoderService& m_decoder;
+    juce::ThreadPool m_pool;
+    std::shared_ptr<Batch> m_batch;
+    bool m_useResultFiles = false;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchAnalyzer)
+};
@@ -0,0 +1,287 @@
+#include "DirectoryIndex.h"
+#include "TimerBenchmark.h"
+#include <algorithm>
+
+//==============================================================================
+
+bool DirectoryIndex::setDirectory(const juce::File& directory, bool recursive, bool scan)
+{
+    if (directory != m_directory || recursive != m_recursive)
+    {
+        clear();
+        m_directory = directory;
+        m_recursive = recursive;
+        if (scan)
+            rescan();
+    }
+    return m_directory.isDirectory();
+}
+
+void DirectoryIndex::clear()
+{
+    m_takes.clear();
+    for (auto& heap : m_heaps)
+        heap.clear();
+}
+
+DirectoryIndex::Scan DirectoryIndex::scanDirectory(const juce::File& directory, bool recursive)
+{
+    Scan scan;
+    scan.directory = directory;
+    scan.recursive = recursive;
+    if (!directory.isDirectory())
+        return scan;
+
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, recursive, "*", juce::File::findFiles))
+    {
+        if (isTake(entry.getFile()))
+            scan.entries.push_back({ entry.getFile(), entry.getFileSize(), entry.getModificationTime(), entry.getCreationTime() });
+    }
+    return scan;
+}
+
+void DirectoryIndex::applyScan(const Scan& scan)
+{
+    if (scan.directory != m_directory || scan.recursive != m_recursive)
+        return;
+    if (!m_directory.isDirectory())
+    {
+        clear();
+        return;
+    }
+
+    m_scan++;
+    for (const Scan::Entry& entry : scan.entries)
+        updateTake(entry.file, entry.size, entry.modificationTime, entry.creationTime);
+
+    //takes that weren't found again were removed, their heap entries are skipped
+    for (auto take = m_takes.begin(); take != m_takes.end();)
+    {
+        if (take->second.scan != m_scan)
+            take = m_takes.erase(take);
+        else
+            ++take;
+    }
+}
+
+void DirectoryIndex::updateFile(const juce::File& file)
+{
+    if (!isTake(file))
+        return;
+    if (m_recursive ? !file.isAChildOf(m_directory) : file.getParentDirectory() != m_directory)
+        return;
+
+    if (!file.existsAsFile())
+        m_takes.erase(file.getFullPathName());
+    else
+        updateTake(file, file.getSize(), file.getLastModificationTime(), file.getCreationTime());
+}
+
+juce::File DirectoryIndex::getNewest(Format format)
+{
+    auto& heap = m_heaps[(int)format];
+    while (!heap.empty())
+    {
+        auto take = m_takes.find(heap.front().path);
+        if (take != m_takes.end() && take->second.version == heap.front().version)
+        {
+            const juce::File& file = take->second.file;
+            if (!file.existsAsFile())
+            {
+                m_takes.erase(take);
+            }
+            else if (file.getSize() != take->second.size || file.getLastModificationTime() != take->second.modificationTime)
+            {
+                //changed without an updateFile, its new version is in the heap now
+                updateFile(juce::File(file));
+                continue;
+            }
+            else if (checkTake(take->second))
+            {
+                return file;
+            }
+        }
+        //removed, changed or unreadable, an unreadable take is pushed again when it changes
+        std::pop_heap(heap.begin(), heap.end());
+        heap.pop_back();
+    }
+    return juce::File();
+}
+
+bool DirectoryIndex::canRead(const juce::File& file)
+{
+    updateFile(file);
+    auto take = m_takes.find(file.getFullPathName());
+    return take != m_takes.end() && checkTake(take->second);
+}
+
+juce::Array<juce::File> DirectoryIndex::getTakes(Format format) const
+{
+    juce::Array<juce::File> takes;
+    for (const auto& take : m_takes)
+    {
+        if (take.second.format == format)
+            takes.add(take.second.file);
+    }
+    return takes;
+}
+
+void DirectoryIndex::updateTake(const juce::File& file, juce::int64 size, juce::Time modificationTime, juce::Time creationTime)
+{
+    juce::String path = file.getFullPathName();
+    Take& take = m_takes[path];
+    take.scan = m_scan;
+    if (take.size == size && take.modificationTime == modificationTime)
+        return;
+
+    take.file = file;
+    take.format = getFormat(file);
+    take.size = size;
+    take.modificationTime = modificationTime;
+    take.msTime = juce::jmax(creationTime.toMilliseconds(), modificationTime.toMilliseconds());
+    take.validity = Take::Validity::unknown;
+    take.version = ++m_version;
+
+    auto& heap = m_heaps[(int)take.format];
+    heap.push_back({ take.msTime, take.version, path });
+    std::push_heap(heap.begin(), heap.end());
+    if (heap.size() > 2 * m_takes.size() + 64)
+        compactHeap(take.format);
+}
+
+bool DirectoryIndex::checkTake(Take& take)
+{
+    if (take.validity == Take::Validity::unknown)
+    {
+        m_numParses++;
+        take.validity = m_canRead(take.file, take.format) ? Take::Validity::readable : Take::Validity::unreadable;
+    }
+    return take.validity == Take::Validity::readable;
+}
+
+void DirectoryIndex::compactHeap(Format format)
+{
+    auto& heap = m_heaps[(int)format];
+    heap.clear();
+    for (const auto& take : m_takes)
+    {
+        if (take.second.format == format && take.second.validity != Take::Validity::unreadable)
+            heap.push_back({ take.second.msTime, take.second.version, take.first });
+    }
+    std::make_heap(heap.begin(), heap.end());
+}
+
+//==============================================================================
+
+BenchmarkResult DirectoryIndex::benchmark(int numTakes)
+{
+    juce::File directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("DirectoryIndexBenchmark");
+    directory.deleteRecursively();
+    juce::File sessionDirectory = directory.getChildFile("session");
+    sessionDirectory.createDirectory();
+
+    //every take in the future so its modification time is newer than its creation time, one second apart so the
+    //newest take is unique. A third of the takes are in a session subfolder, every tenth one is empty and unreadable
+    juce::Time start = juce::Time::getCurrentTime() + juce::RelativeTime::days(1);
+    juce::Random random(numTakes);
+    juce::Array<int> order;
+    for (int i = 0; i < numTakes; i++)
+        order.insert(random.nextInt(order.size() + 1), i);
+    for (int i = 0; i < numTakes; i++)
+    {
+        juce::File take = (i % 3 == 0 ? sessionDirectory : directory).getChildFile("take " + juce::String(i) + ".mid");
+        take.replaceWithText(i % 10 == 0 ? "" : "MThd");
+        take.setLastModificationTime(start + juce::RelativeTime::seconds(order[i]));
+    }
+
+    int numParses = 0;
+    CanRead canRead = [&numParses](const juce::File& take, Format)
+    {
+        numParses++;
+        return take.getSize() > 0;
+    };
+
+    //what getNewFile of the editor did before the index, every file compared and the newest one parsed
+    auto findNewest = [&]()
+    {
+        juce::File newest;
+        juce::int64 newestTime = 0;
+        for (const auto& entry : juce::RangedDirectoryIterator(directory, true, "*", juce::File::findFiles))
+        {
+            juce::int64 time = juce::jmax(entry.getCreationTime().toMilliseconds(), entry.getModificationTime().toMilliseconds());
+            if (AnalysisCore::isMidiFile(entry.getFile()) && canRead(entry.getFile(), Format::midi) && time > newestTime)
+            {
+                newest = entry.getFile();
+                newestTime = time;
+            }
+        }
+        return newest;
+    };
+
+    juce::String output = "DirectoryIndex::benchmark " + juce::String(numTakes) + " takes\n";
+    TimerBench timerBench;
+    DirectoryIndex index(canRead);
+    index.setDirectory(directory, true);
+    output += timerBench.StopAndGetTime("index (us)") + "\n";
+
+    timerBench.Start();
+    juce::File newest = index.getNewest(Format::midi);
+    output += timerBench.StopAndGetTime("first getNewest (us)") + ", parses: " + juce::String(numParses) + "\n";
+
+    const int numCalls = 1000;
+    numParses = 0;
+    timerBench.Start();
+    for (int i = 0; i < numCalls; i++)
+        newest = index.getNewest(Format::midi);
+    output += timerBench.StopAndGetTime(juce::String(numCalls) + " getNewest (us)") + ", parses: " + juce::String(numParses) + "\n";
+
+    timerBench.Start();
+    index.rescan();
+    output += timerBench.StopAndGetTime("rescan without changes (us)") + "\n";
+
+    numParses = 0;
+    timerBench.Start();
+    juce::File found = findNewest();
+    output += timerBench.StopAndGetTime("find newest without the index (us)") + ", parses: " + juce::String(numParses) + "\n";
+
+    //takes written again, half of them readable, and takes removed
+    int mismatches = newest != found ? 1 : 0;
+    const int numChanges = 100;
+    timerBench.Start();
+    for (int i = 0; i < numChanges; i++)
+    {
+        juce::File take = (i % 3 == 0 ? sessionDirectory : directory).getChildFile("take " + juce::String(random.nextInt(numTakes)) + ".mid");
+        if (i % 7 == 6)
+        {
+            take.deleteFile();
+        }
+        else
+        {
+            take.replaceWithText(i % 2 == 0 ? "" : "MThd");
+            take.setLastModificationTime(start + juce::RelativeTime::seconds(numTakes + i));
+        }
+        index.updateFile(take);
+        if (index.getNewest(Format::midi) != findNewest())
+            mismatches++;
+    }
+    output += timerBench.StopAndGetTime(juce::String(numChanges) + " changes with updateFile, getNewest and the check (us)") + "\n";
+
+    //a new newest take removed by a rescan and written again as the oldest, its old heap entry must not come back
+    juce::File recreated = directory.getChildFile("recreated.mid");
+    recreated.replaceWithText("MThd");
+    recreated.setLastModificationTime(start + juce::RelativeTime::days(1));
+    index.updateFile(recreated);
+    if (index.getNewest(Format::midi) != recreated)
+        mismatches++;
+    recreated.deleteFile();
+    index.rescan();
+    recreated.replaceWithText("MThd");
+    recreated.setLastModificationTime(start - juce::RelativeTime::days(2));
+    index.updateFile(recreated);
+    if (index.getNewest(Format::midi) != findNewest())
+        mismatches++;
+    output += "mismatches: " + juce::String(mismatches) + "\n";
+
+    directory.deleteRecursively();
+    return { output, mismatches };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "AnalysisCore.h"
+#include <map>
+
+//==============================================================================
+//the takes of a midi folder with their size, modification time and whether they could be read, kept up to date by
+//stating the folder or by single file changes instead of reading the folder again. The takes of each format are in a
+//max-heap by time, so the newest readable take is the top of the heap once it was checked. Only used on one thread,
+//scanDirectory can list a directory on another thread for applyScan
+class DirectoryIndex
+{
+public:
+    enum class Format { midi, audio };
+    //parses the take, only called again after the take changed
+    typedef std::function<bool(const juce::File& take, Format format)> CanRead;
+
+    struct Take
+    {
+        enum class Validity { unknown, readable, unreadable };
+
+        juce::File file;
+        Format format = Format::midi;
+        juce::int64 size = -1;
+        juce::Time modificationTime;
+        //the later of the creation and modification time, a take that is written again is new again
+        juce::int64 msTime = 0;
+        //of the size and modification time above
+        Validity validity = Validity::unknown;
+        //from the counter of the index, so a take that was removed and added again doesn't reuse a version.
+        //Heap entries of an older version are skipped
+        juce::uint32 version = 0;
+        juce::uint32 scan = 0;
+    };
+
+    //the takes of a directory as they were listed
+    struct Scan
+    {
+        struct Entry
+        {
+            juce::File file;
+            juce::int64 size = 0;
+            juce::Time modificationTime;
+            juce::Time creationTime;
+        };
+
+        juce::File directory;
+        bool recursive = false;
+        std::vector<Entry> entries;
+    };
+
+    explicit DirectoryIndex(CanRead canRead) : m_canRead(std::move(canRead)) {}
+
+    //clears the index if the directory or recursive changed and indexes it again unless scan is false, takes in
+    //subfolders are only indexed when recursive. Returns false if the directory doesn't exist
+    bool setDirectory(const juce::File& directory, bool recursive, bool scan = true);
+    const juce::File& getDirectory() const { return m_directory; }
+    bool isRecursive() const { return m_recursive; }
+    void clear();
+
+    //stats the takes of the directory and only updates the ones that were added, changed or removed
+    void rescan() { applyScan(scanDirectory(m_directory, m_recursive)); }
+    //lists the takes of a directory, safe to call from any thread
+    static Scan scanDirectory(const juce::File& directory, bool recursive);
+    //rescan with the takes of a scan, ignored if the scan is of another directory
+    void applyScan(const Scan& scan);
+    //updates one take after a DirectoryWatcher reported it, ignores files outside the directory
+    void updateFile(const juce::File& file);
+
+    //the newest take of the format that can be read, or File() if there is none. Takes are only parsed if they are
+    //newer than the newest one that could be read
+    juce::File getNewest(Format format);
+    //parses the take only if it changed since it was last parsed
+    bool canRead(const juce::File& file);
+    //in path order
+    juce::Array<juce::File> getTakes(Format format) const;
+
+    int getNumTakes() const { return (int)m_takes.size(); }
+    //calls of canRead, to see how many parses the index saved
+    int getNumParses() const { return m_numParses; }
+
+    static Format getFormat(const juce::File& file) { return AnalysisCore::isAudioFile(file) ? Format::audio : Format::midi; }
+    static bool isTake(const juce::File& file) { return AnalysisCore::isMidiFile(file) || AnalysisCore::isAudioFile(file); }
+
+    //compares the newest take with the take found by comparing the times of every file, on numTakes empty takes in a
+    //temporary folder. Every change after which they differ fails
+    static BenchmarkResult benchmark(int numTakes);
+
+private:
+    struct HeapEntry
+    {
+        juce::int64 msTime;
+        juce::uint32 version;
+        juce::String path;
+
+        bool operator<(const HeapEntry& other) const { return msTime < other.msTime; }
+    };
+
+    void updateTake(const juce::File& file, juce::int64 size, juce::Time modificationTime, juce::Time creationTime);
+    //the take was parsed with its current size and modification time
+    bool checkTake(Take& take);
+    //drops the entries of changed or removed takes when they are most of the heap
+    void compactHeap(Format format);
+
+    juce::File m_directory;
+    bool m_recursive = false;
+    CanRead m_canRead;
+
+    std::map<juce::String, Take> m_takes;
+    std::vector<HeapEntry> m_heaps[2];
+    juce::uint32 m_scan = 0;
+    juce::uint32 m_version = 0;
+    int m_numParses = 0;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DirectoryIndex)
+};
@@ -0,0 +1,196 @@
+#include "DirectoryWatcher.h"
+
+#if JUCE_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+//==============================================================================
+
+bool DirectoryWatcher::start(const juce::File& directory, ChangeCallback changeCallback, int msPollInterval, bool recursive)
+{
+    stop();
+    if (!directory.isDirectory() || changeCallback == nullptr)
+        return false;
+
+    m_directory = directory;
+    m_changeCallback = std::move(changeCallback);
+    m_msPollInterval = juce::jmax(10, msPollInterval);
+    m_recursive = recursive;
+    startThread();
+    return true;
+}
+
+void DirectoryWatcher::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+    m_eventDriven = false;
+}
+
+void DirectoryWatcher::run()
+{
+    if (!runInotify() && !threadShouldExit())
+        runPolling();
+}
+
+bool DirectoryWatcher::runInotify()
+{
+#if JUCE_LINUX
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    //the directory of every watch, a subfolder gets its own watch when it's created
+    std::map<int, juce::File> watchedDirectories;
+    auto addWatch = [&](const juce::File& directory)
+    {
+        int watch = inotify_add_watch(fd, directory.getFullPathName().toRawUTF8(),
+                                      IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+        if (watch >= 0)
+            watchedDirectories[watch] = directory;
+        return watch >= 0;
+    };
+    auto addSubfolderWatches = [&](const juce::File& directory)
+    {
+        for (const auto& entry : juce::RangedDirectoryIterator(directory, true, "*", juce::File::findDirectories))
+            addWatch(entry.getFile());
+    };
+
+    if (!addWatch(m_directory))
+    {
+        close(fd);
+        return false;
+    }
+    if (m_recursive)
+        addSubfolderWatches(m_directory);
+    m_eventDriven = true;
+    //every change from here on is an event, the files from before are scanned once
+    m_changeCallback(m_directory, Change::rescanNeeded);
+
+    //files that were written since they were created or last closed, so a recording only reports its first write
+    std::set<juce::String> modifiedFiles;
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    pollfd pollFd{ fd, POLLIN, 0 };
+    while (!threadShouldExit())
+    {
+        //wakes up now and then to check threadShouldExit
+        if (poll(&pollFd, 1, 100) <= 0)
+            continue;
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* position = buffer; position < buffer + length;)
+            {
+                const inotify_event* event = (const inotify_event*)position;
+                position += sizeof(inotify_event) + event->len;
+                if ((event->mask & IN_Q_OVERFLOW) != 0)
+                {
+                    //a write that was lost reports its first write again
+                    modifiedFiles.clear();
+                    m_changeCallback(m_directory, Change::rescanNeeded);
+                    continue;
+                }
+
+                auto directory = watchedDirectories.find(event->wd);
+                if (event->len == 0 || directory == watchedDirectories.end())
+                    continue;
+
+                juce::File file = directory->second.getChildFile(juce::String::fromUTF8(event->name));
+                if ((event->mask & IN_ISDIR) != 0)
+                {
+                    //takes written before the watch was added are only reported when they're closed
+                    if (m_recursive && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 && addWatch(file))
+                        addSubfolderWatches(file);
+                    continue;
+                }
+
+                juce::String path = file.getFullPathName();
+                if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0)
+                {
+                    modifiedFiles.erase(path);
+                    m_changeCallback(file, Change::closedAfterWrite);
+                }
+                else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
+                {
+                    modifiedFiles.erase(path);
+                    m_changeCallback(file, Change::removed);
+                }
+                else if ((event->mask & IN_CREATE) != 0)
+                {
+                    m_changeCallback(file, Change::created);
+                }
+                else if ((event->mask & IN_MODIFY) != 0 && modifiedFiles.insert(path).second)
+                {
+                    m_changeCallback(file, Change::modified);
+                }
+            }
+        }
+    }
+    close(fd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DirectoryWatcher::runPolling()
+{
+    struct FileState
+    {
+        juce::int64 size = 0;
+        juce::Time modificationTime;
+        //changed since it was closed
+        bool writing = false;
+        bool modifiedReported = false;
+    };
+
+    //the files that are already there aren't reported
+    std::map<juce::String, FileState> files;
+    for (const auto& entry : juce::RangedDirectoryIterator(m_directory, m_recursive, "*", juce::File::findFiles))
+        files[entry.getFile().getFullPathName()] = { entry.getFileSize(), entry.getModificationTime() };
+    m_changeCallback(m_directory, Change::rescanNeeded);
+
+    while (!threadShouldExit())
+    {
+        wait(m_msPollInterval);
+        if (threadShouldExit())
+            break;
+
+        std::map<juce::String, FileState> scanned;
+        for (const auto& entry : juce::RangedDirectoryIterator(m_directory, m_recursive, "*", juce::File::findFiles))
+        {
+            juce::String path = entry.getFile().getFullPathName();
+            FileState state{ entry.getFileSize(), entry.getModificationTime() };
+            auto previous = files.find(path);
+            if (previous == files.end())
+            {
+                state.writing = true;
+                m_changeCallback(entry.getFile(), Change::created);
+            }
+            else if (previous->second.size != state.size || previous->second.modificationTime != state.modificationTime)
+            {
+                state.writing = true;
+                state.modifiedReported = true;
+                if (!previous->second.modifiedReported)
+                    m_changeCallback(entry.getFile(), Change::modified);
+            }
+            else if (previous->second.writing)
+            {
+                //unchanged for one poll after it was written
+                m_changeCallback(entry.getFile(), Change::closedAfterWrite);
+            }
+            scanned[path] = state;
+        }
+        for (const auto& [path, state] : files)
+        {
+            if (scanned.count(path) == 0)
+                m_changeCallback(juce::File(path), Change::removed);
+        }
+        files = std::move(scanned);
+    }
+}
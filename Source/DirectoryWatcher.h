@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Globals.h"
+#include <map>
+#include <set>
+
+//==============================================================================
+//reports the files of a directory, and of its subfolders when recursive, that are created, written, closed after
+//writing or removed, on a thread of its own so the message thread never scans the directory. On linux the changes
+//come from inotify, elsewhere (or if inotify can't watch the directory) the directory is polled and a file counts as
+//closed once its size and modification time stopped changing for one poll
+class DirectoryWatcher : private juce::Thread
+{
+public:
+    enum class Change
+    {
+        created,
+        //only the first write after a file was created or closed, not every write while it's recorded
+        modified,
+        //written and closed, or moved into the directory. The file is complete
+        closedAfterWrite,
+        //deleted or moved out of the directory
+        removed,
+        //the watch started, or the inotify queue overflowed and its events were lost. file is the directory, the
+        //files that changed before are only found by scanning it again on the watcher thread
+        rescanNeeded
+    };
+
+    //called on the watcher thread
+    typedef std::function<void(const juce::File& file, Change change)> ChangeCallback;
+
+    DirectoryWatcher() : juce::Thread("DirectoryWatcher") {}
+    ~DirectoryWatcher() override { stop(); }
+
+    //stops watching the previous directory. msPollInterval is only used when the directory has to be polled
+    bool start(const juce::File& directory, ChangeCallback changeCallback, int msPollInterval = 1000, bool recursive = false);
+    void stop();
+
+    bool isWatching() const { return isThreadRunning(); }
+    const juce::File& getDirectory() const { return m_directory; }
+    int getPollInterval() const { return m_msPollInterval; }
+    bool isRecursive() const { return m_recursive; }
+    //false while the directory is polled
+    bool isEventDriven() const { return m_eventDriven; }
+
+private:
+    void run() override;
+    //returns false if inotify can't watch the directory
+    bool runInotify();
+    void runPolling();
+
+    juce::File m_directory;
+    ChangeCallback m_changeCallback;
+    int m_msPollInterval = 1000;
+    bool m_recursive = false;
+    std::atomic<bool> m_eventDriven{ false };
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DirectoryWatcher)
+};
@@ -7,11 +7,11 @@
 
 inline const double g_defaultQuarterNoteTicks = 960;
 
+#if JUCE_MODULE_AVAILABLE_juce_gui_basics
 inline juce::Font getMonoFont(float fontHeight = 14.f) { return juce::Font("Cascadia Mono", fontHeight, 0); }
 inline const juce::Colour g_defaultEditorColor = juce::Colour(38, 50, 56);
 
 typedef juce::Rectangle<int> Bounds;
-typedef juce::String jString;
 
 
 //return the expanded area
@@ -31,6 +31,22 @@ void fitButtonInLeftBounds(Bounds& bounds, ButtonType& button, int height = -1)
 		height = bounds.getHeight();
 	button.setBounds(bounds.removeFromLeft(button.getWidth()).withHeight(height));
 }
+#endif
+
+typedef juce::String jString;
+
+//a timer that calls a lambda, for a class that needs more than one timer
+class CallbackTimer : public juce::Timer
+{
+public:
+	std::function<void()> callback;
+
+	void timerCallback() override
+	{
+		if (callback)
+			callback();
+	}
+};
 
 inline juce::String getValueTreeID(juce::ValueTree& valueTree) { return valueTree.getType().toString(); }
 inline juce::XmlElement::TextFormat getXmlNoWrapFormat()
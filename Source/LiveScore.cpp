@@ -0,0 +1,180 @@
+#include "LiveScore.h"
+#include "LockFree.h"
+#include "AnalysisCore.h"
+#include <thread>
+
+//==============================================================================
+
+void LiveScore::add(double msDeviation, bool onTime)
+{
+    numHits++;
+    numMatched++;
+    if (onTime)
+        numOnTime++;
+
+    double delta = msDeviation - mean;
+    mean += delta / numMatched;
+    m2 += delta * (msDeviation - mean);
+    sumAbsoluteDeviation += std::abs(msDeviation);
+
+    recentMS[(size_t)(numAdded % numRecent)] = (float)msDeviation;
+    numAdded++;
+}
+
+juce::String LiveScore::toString() const
+{
+    if (numHits == 0)
+        return "no live hits";
+
+    auto ms = [](double value) { return juce::String(value, 1); };
+
+    juce::String output;
+    output += "live hits: " + juce::String(numHits);
+    output += ", extra: " + juce::String(numHits - numMatched);
+    output += ", on time: " + juce::String(juce::roundToInt(getOnTimeRatio() * 100)) + "%";
+    output += ", mean: " + juce::String(mean >= 0 ? "+" : "") + ms(mean) + " ms";
+    output += ", mean abs: " + ms(getMeanAbsoluteDeviation()) + " ms";
+    output += ", sd: " + ms(getStandardDeviation()) + " ms";
+    output += ", last:";
+    for (int age = getNumRecent() - 1; age >= 0; age--)
+        output += " " + juce::String(getRecent(age) >= 0 ? "+" : "") + juce::String(juce::roundToInt(getRecent(age)));
+    return output;
+}
+
+//==============================================================================
+
+LiveReference::LiveReference(const vArray<MidiEvent>& quantizedMidi, const juce::Array<juce::Array<int>>& pitchGroups,
+                             double recordBeatStart, double msTimeThreshold, std::shared_ptr<const TempoMap> tempoMap)
+    : quantizedMidi(quantizedMidi), recordBeatStart(recordBeatStart), msTimeThreshold(msTimeThreshold), tempoMap(std::move(tempoMap))
+{
+    matcher.setPitchGroups(pitchGroups);
+    matcher.setReference(quantizedMidi);
+    matcher.prepareCursor(cursor);
+}
+
+LiveReference::ScoredHit LiveReference::scoreHit(LiveScore& score, double ppqPosition, double bpm, int note) const
+{
+    ScoredHit scoredHit;
+    if (bpm <= 0)
+        return scoredHit;
+
+    //relative to the record start like the hits of a take
+    MidiEvent midi((ppqPosition - recordBeatStart) * 60000 / bpm, bpm, note < 0, juce::jmax(0, note));
+    //the host beat is already on the tempo map
+    if (tempoMap != nullptr)
+        midi.tickStart = midi.tickEnd = (ppqPosition - recordBeatStart) * g_defaultQuarterNoteTicks;
+    int closest = matcher.findClosest(midi, MidiMatcher::normalizeTick(midi) + recordBeatStart * g_defaultQuarterNoteTicks, cursor);
+    if (closest < 0 || closest >= quantizedMidi.size())
+    {
+        score.addExtra();
+        return scoredHit;
+    }
+
+    double msDeviation = AnalysisCore::getMSDeviation(midi, quantizedMidi.getReference(closest), recordBeatStart, bpm, tempoMap.get());
+    scoredHit.matched = true;
+    scoredHit.msDeviation = msDeviation;
+    scoredHit.onTime = std::abs(msDeviation) <= msTimeThreshold;
+    score.add(msDeviation, scoredHit.onTime);
+    return scoredHit;
+}
+
+//==============================================================================
+
+BenchmarkResult LiveScore::benchmark(int numSeconds)
+{
+    //every field of a published score is derived from numHits, so a read is whole if they all agree
+    auto makeScore = [](int numHits)
+    {
+        LiveScore score;
+        score.numHits = numHits;
+        score.numMatched = numHits / 2;
+        score.numOnTime = numHits / 4;
+        score.mean = numHits * 0.5;
+        score.m2 = numHits * 2.0;
+        score.sumAbsoluteDeviation = -numHits;
+        for (int i = 0; i < LiveScore::numRecent; i++)
+            score.recentMS[(size_t)i] = (float)(numHits + i);
+        score.numAdded = numHits;
+        return score;
+    };
+    auto isWhole = [&](const LiveScore& score)
+    {
+        LiveScore expected = makeScore(score.numHits);
+        return score.numMatched == expected.numMatched && score.numOnTime == expected.numOnTime && score.mean == expected.mean
+            && score.m2 == expected.m2 && score.sumAbsoluteDeviation == expected.sumAbsoluteDeviation
+            && score.recentMS == expected.recentMS && score.numAdded == expected.numAdded;
+    };
+
+    TripleBuffer<LiveScore> tripleBuffer;
+    std::atomic<bool> stop{ false };
+    int numPublished = 0;
+    std::thread publisher([&]()
+    {
+        //the audio thread side, publishing a new score as fast as it can
+        while (!stop.load(std::memory_order_relaxed))
+            tripleBuffer.publish(makeScore(++numPublished));
+    });
+
+    int numReads = 0;
+    int numTorn = 0;
+    int numBackwards = 0;
+    int lastHits = 0;
+    double endTime = juce::Time::getMillisecondCounterHiRes() + numSeconds * 1000.0;
+    LiveScore score;
+    while (juce::Time::getMillisecondCounterHiRes() < endTime)
+    {
+        if (!tripleBuffer.read(score))
+            continue;
+        numReads++;
+        if (!isWhole(score))
+            numTorn++;
+        //the reader never gets an older score than the one before
+        if (score.numHits < lastHits)
+            numBackwards++;
+        lastHits = score.numHits;
+    }
+    stop = true;
+    publisher.join();
+
+    juce::String output = "LiveScore::benchmark " + juce::String(numSeconds) + " s\n";
+    output += "published: " + juce::String(numPublished) + ", read: " + juce::String(numReads) + "\n";
+    output += "torn reads: " + juce::String(numTorn) + ", older than the previous read: " + juce::String(numBackwards) + "\n";
+
+    //the work of one hit on the audio thread against a reference of 100000 notes
+    juce::Random random(numSeconds);
+    vArray<MidiEvent> quantizedMidi;
+    for (int i = 0; i < 100000; i++)
+        quantizedMidi.add(MidiEvent(i * 125.0, 120, false, 36 + random.nextInt(8)));
+    LiveReference reference(quantizedMidi, { { 36, 37 } }, 0, 20);
+    const int numHits = 100000;
+    TimerBench timerBench;
+    LiveScore liveScore;
+    for (int i = 0; i < numHits; i++)
+        reference.scoreHit(liveScore, random.nextDouble() * 25000, 120, random.nextBool() ? -1 : 36 + random.nextInt(8));
+    output += timerBench.StopAndGetTime(juce::String(numHits) + " scoreHit in random order (us)") + "\n";
+    output += liveScore.toString() + "\n";
+
+    //hits of a take arrive in time order, so the cursor only walks to the next notes
+    std::vector<std::pair<double, int>> hits;
+    for (int i = 0; i < numHits; i++)
+        hits.push_back({ i * 0.25 + random.nextDouble() * 0.2 - 0.1, random.nextBool() ? -1 : 36 + random.nextInt(8) });
+    LiveReference orderedReference(quantizedMidi, { { 36, 37 } }, 0, 20);
+    timerBench.Start();
+    liveScore = LiveScore();
+    for (auto& [ppqPosition, note] : hits)
+        orderedReference.scoreHit(liveScore, ppqPosition, 120, note);
+    output += timerBench.StopAndGetTime(juce::String(numHits) + " scoreHit in time order (us)") + "\n";
+
+    int numMismatches = 0;
+    MidiMatcher::Cursor cursor;
+    orderedReference.matcher.prepareCursor(cursor);
+    for (auto& [ppqPosition, note] : hits)
+    {
+        MidiEvent midi(ppqPosition * 500, 120, note < 0, juce::jmax(0, note));
+        double tick = MidiMatcher::normalizeTick(midi);
+        if (orderedReference.matcher.findClosest(midi, tick, cursor) != orderedReference.matcher.findClosest(midi, tick))
+            numMismatches++;
+    }
+    output += "cursor mismatches: " + juce::String(numMismatches) + "\n";
+    return { output, numTorn + numBackwards + numMismatches };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Globals.h"
+#include "MidiEvent.h"
+#include "MidiMatcher.h"
+#include "TempoMap.h"
+#include <array>
+#include <memory>
+
+//==============================================================================
+//running timing of the live hits, fixed size so the audio thread can publish copies of it without allocating.
+//Deviations are in ms and positive when late like TimingSummary
+struct LiveScore
+{
+    static const int numRecent = 16;
+
+    void add(double msDeviation, bool onTime);
+    void addExtra() { numHits++; }
+
+    double getOnTimeRatio() const { return numMatched > 0 ? (double)numOnTime / numMatched : 0; }
+    double getMeanAbsoluteDeviation() const { return numMatched > 0 ? sumAbsoluteDeviation / numMatched : 0; }
+    double getStandardDeviation() const { return numMatched > 1 ? std::sqrt(m2 / (numMatched - 1)) : 0; }
+    int getNumRecent() const { return juce::jmin(numAdded, numRecent); }
+    //deviation of a recent matched hit, 0 is the newest
+    float getRecent(int age) const { return recentMS[(size_t)((numAdded - 1 - age) % numRecent)]; }
+
+    juce::String toString() const;
+
+    //publishes scores from one thread while another reads them as fast as it can, every read that isn't one whole
+    //published score or is older than the read before fails. Also times LiveReference::scoreHit on a long reference
+    //and fails every hit where the cursor and a search find different notes
+    static BenchmarkResult benchmark(int numSeconds);
+
+    int numHits = 0;
+    //hits that matched a note of the reference
+    int numMatched = 0;
+    int numOnTime = 0;
+    //signed, running mean and sum of squared differences (Welford)
+    double mean = 0;
+    double m2 = 0;
+    double sumAbsoluteDeviation = 0;
+    std::array<float, numRecent> recentMS{};
+    int numAdded = 0;
+};
+
+//==============================================================================
+//the quantized midi the live hits are scored against, built on the message thread and then only read by the audio thread
+struct LiveReference
+{
+    LiveReference(const vArray<MidiEvent>& quantizedMidi, const juce::Array<juce::Array<int>>& pitchGroups,
+                  double recordBeatStart, double msTimeThreshold, std::shared_ptr<const TempoMap> tempoMap = nullptr);
+
+    struct ScoredHit
+    {
+        bool matched = false;
+        double msDeviation = 0;
+        bool onTime = false;
+    };
+
+    //matches one hit by walking the cursor from the previous hit and adds it to the score, never allocates.
+    //ppqPosition is the absolute host beat of the hit, note is -1 for a hit without a pitch
+    ScoredHit scoreHit(LiveScore& score, double ppqPosition, double bpm, int note) const;
+
+    vArray<MidiEvent> quantizedMidi;
+    MidiMatcher matcher;
+    //absolute beat of the record start
+    double recordBeatStart = 0;
+    double msTimeThreshold = 20;
+    //the deviation of a hit is taken through the tempo changes of the reference instead of the host bpm, released
+    //with the reference on the message thread
+    std::shared_ptr<const TempoMap> tempoMap;
+    //the reference notes of the previous hit, prepared with the reference and then only moved by the audio thread
+    mutable MidiMatcher::Cursor cursor;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Globals.h"
+#include <memory>
+#include <vector>
+
+//==============================================================================
+//fixed size queue for one thread that pushes and one thread that pops, like the audio thread and the message thread.
+//Never allocates or locks after it's constructed, a push to a full queue is dropped and counted
+template <typename Type>
+class SpscQueue
+{
+public:
+    SpscQueue(int capacity)
+        : m_fifo(capacity), m_items((size_t)capacity)
+    {
+    }
+
+    //producer thread only
+    bool push(const Type& item)
+    {
+        auto scope = m_fifo.write(1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+        {
+            m_numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = item;
+        return true;
+    }
+
+    //consumer thread only
+    bool pop(Type& item)
+    {
+        auto scope = m_fifo.read(1);
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+        item = m_items[(size_t)(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+        return true;
+    }
+
+    //consumer thread only, pops everything that was pushed so far
+    template <typename Callback>
+    int popAll(Callback&& callback)
+    {
+        int numPopped = 0;
+        Type item;
+        while (pop(item))
+        {
+            callback(item);
+            numPopped++;
+        }
+        return numPopped;
+    }
+
+    //consumer thread only, drops everything that was pushed so far
+    void clear()
+    {
+        m_fifo.read(m_fifo.getNumReady());
+    }
+
+    int getNumReady() const { return m_fifo.getNumReady(); }
+    int getFreeSpace() const { return m_fifo.getFreeSpace(); }
+    int getCapacity() const { return m_fifo.getTotalSize(); }
+    int getNumDropped() const { return m_numDropped.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo m_fifo;
+    std::vector<Type> m_items;
+    std::atomic<int> m_numDropped{ 0 };
+
+private:
+    JUCE_DECLARE_NON_COPYABLE(SpscQueue)
+};
+
+//==============================================================================
+//latest value of one writer thread for one reader thread. Both sides only swap an index, the writer never waits
+//for the reader and the reader always gets a whole value that was published, never a mix of two
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() {}
+
+    //writer thread only, copies the value so it should be small and fixed size on the audio thread
+    void publish(const Type& value)
+    {
+        m_buffers[m_writeIndex] = value;
+        int previous = m_middle.exchange(m_writeIndex | freshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & indexMask;
+    }
+
+    //reader thread only, false if nothing was published since the last read
+    bool read(Type& value)
+    {
+        if ((m_middle.load(std::memory_order_acquire) & freshBit) == 0)
+            return false;
+        int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & indexMask;
+        value = m_buffers[m_readIndex];
+        return true;
+    }
+
+private:
+    static const int indexMask = 3;
+    static const int freshBit = 4;
+
+    Type m_buffers[3];
+    int m_writeIndex = 0;
+    //the buffer between the writer and the reader, with freshBit set when the writer published it
+    std::atomic<int> m_middle{ 1 };
+    int m_readIndex = 2;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
+
+//==============================================================================
+//an object that the message thread replaces while the audio thread uses it. The audio thread takes a new object
+//with an atomic swap and hands the old one back, so it never allocates or deletes and the message thread deletes
+//the old ones the next time it sets or collects
+template <typename Type>
+class RealtimeHandover
+{
+public:
+    RealtimeHandover() {}
+
+    ~RealtimeHandover()
+    {
+        collectGarbage();
+        delete m_pending.exchange(nullptr);
+        delete m_current;
+    }
+
+    //message thread only, an object that the audio thread didn't take yet is replaced
+    void set(std::unique_ptr<Type> object)
+    {
+        collectGarbage();
+        delete m_pending.exchange(object.release(), std::memory_order_acq_rel);
+    }
+
+    //message thread only, deletes the objects the audio thread handed back
+    void collectGarbage()
+    {
+        m_retired.popAll([](Type* object) { delete object; });
+    }
+
+    //audio thread only, true if a new object was taken. Waits for the message thread to collect when it can't hand back
+    bool update()
+    {
+        if (m_pending.load(std::memory_order_relaxed) == nullptr || m_retired.getFreeSpace() == 0)
+            return false;
+        Type* object = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (object == nullptr)
+            return false;
+        if (m_current != nullptr)
+            m_retired.push(m_current);
+        m_current = object;
+        return true;
+    }
+
+    //audio thread only, the object of the last update or nullptr
+    const Type* get() const { return m_current; }
+
+private:
+    std::atomic<Type*> m_pending{ nullptr };
+    Type* m_current = nullptr;
+    SpscQueue<Type*> m_retired{ 8 };
+
+private:
+    JUCE_DECLARE_NON_COPYABLE(RealtimeHandover)
+};
@@ -0,0 +1,602 @@
+#include "MappedWavFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    //reads a sample as the integer it's stored as, or the float for float32, and gives the threshold in that domain
+    template <MappedWavFile::SampleFormat>
+    struct NativeSample;
+
+    template <>
+    struct NativeSample<MappedWavFile::SampleFormat::int16>
+    {
+        typedef int Type;
+        static const int size = 2;
+        static Type read(const juce::uint8* sample) { return (juce::int16)juce::ByteOrder::littleEndianShort(sample); }
+        static Type readAbsolute(const juce::uint8* sample) { return std::abs(read(sample)); }
+        static float toFloat(Type sample) { return sample / 32768.f; }
+        //float samples are s / 32768, so |s| / 32768 > gain is |s| > gain * 32768 and the integer part of it is enough
+        static Type getThreshold(float gain) { return (Type)juce::jmin(32768.0, std::floor((double)gain * 32768)); }
+    };
+
+    template <>
+    struct NativeSample<MappedWavFile::SampleFormat::int24>
+    {
+        typedef int Type;
+        static const int size = 3;
+        static Type read(const juce::uint8* sample) { return juce::ByteOrder::littleEndian24Bit(sample); }
+        static Type readAbsolute(const juce::uint8* sample) { return std::abs(read(sample)); }
+        static float toFloat(Type sample) { return sample / 8388608.f; }
+        static Type getThreshold(float gain) { return (Type)juce::jmin(8388608.0, std::floor((double)gain * 8388608)); }
+    };
+
+    template <>
+    struct NativeSample<MappedWavFile::SampleFormat::float32>
+    {
+        typedef float Type;
+        static const int size = 4;
+        static Type read(const juce::uint8* sample)
+        {
+            juce::uint32 bits = juce::ByteOrder::littleEndianInt(sample);
+            float value;
+            std::memcpy(&value, &bits, sizeof(float));
+            return value;
+        }
+        static Type readAbsolute(const juce::uint8* sample) { return std::abs(read(sample)); }
+        static float toFloat(Type sample) { return sample; }
+        static Type getThreshold(float gain) { return gain; }
+    };
+
+    //AudioHitDetector::process over a range of the data chunk in one pass, on the peak of all channels or on every channel by itself
+    template <MappedWavFile::SampleFormat format>
+    struct NativeScanner
+    {
+        typedef NativeSample<format> Native;
+        typedef typename Native::Type Type;
+
+        const juce::uint8* samples;
+        int numChannels;
+        bool perChannel;
+        Type threshold;
+        juce::int64 hitDistanceSamples;
+
+        int getNumDetectors() const { return perChannel ? numChannels : 1; }
+        int getFrameSize() const { return Native::size * numChannels; }
+
+        Type read(juce::int64 frame, int detector) const
+        {
+            const juce::uint8* frameStart = samples + frame * getFrameSize();
+            if (perChannel)
+                return Native::readAbsolute(frameStart + detector * Native::size);
+
+            Type peak = 0;
+            for (int channel = 0; channel < numChannels; channel++)
+                peak = juce::jmax(peak, Native::readAbsolute(frameStart + channel * Native::size));
+            return peak;
+        }
+
+        //nextHitStart is the first frame every detector can hit at, it's carried over to the next range
+        bool scan(juce::int64 startFrame, juce::int64 endFrame, std::vector<juce::int64>& nextHitStart,
+                  std::vector<std::pair<juce::int64, int>>& hits, const std::function<bool()>& shouldCancel) const
+        {
+            const int scanBlockSize = AudioHitDetector::scanBlockSize;
+            const juce::int64 cancelInterval = AudioHitDetector::blockSize;
+            const int frameSize = getFrameSize();
+            int numDetectors = getNumDetectors();
+            std::vector<Type> blockPeak((size_t)numDetectors);
+
+            for (juce::int64 blockStart = startFrame; blockStart < endFrame; blockStart += scanBlockSize)
+            {
+                if ((blockStart - startFrame) % cancelInterval == 0 && shouldCancel && shouldCancel())
+                    return false;
+
+                juce::int64 blockEnd = juce::jmin<juce::int64>(blockStart + scanBlockSize, endFrame);
+                if (*std::min_element(nextHitStart.begin(), nextHitStart.end()) >= blockEnd)
+                    continue;
+
+                //the peak of a block first, most of a take is below the threshold
+                std::fill(blockPeak.begin(), blockPeak.end(), (Type)0);
+                const juce::uint8* blockSamples = samples + blockStart * frameSize;
+                int numBlockFrames = (int)(blockEnd - blockStart);
+                if (perChannel)
+                {
+                    for (int i = 0; i < numBlockFrames; i++)
+                    {
+                        for (int channel = 0; channel < numChannels; channel++)
+                            blockPeak[(size_t)channel] = juce::jmax(blockPeak[(size_t)channel], Native::readAbsolute(blockSamples + i * frameSize + channel * Native::size));
+                    }
+                }
+                else
+                {
+                    Type peak = 0;
+                    for (int i = 0; i < numBlockFrames * numChannels; i++)
+                        peak = juce::jmax(peak, Native::readAbsolute(blockSamples + i * Native::size));
+                    blockPeak[0] = peak;
+                }
+
+                for (int detector = 0; detector < numDetectors; detector++)
+                {
+                    if (blockPeak[(size_t)detector] <= threshold)
+                        continue;
+
+                    juce::int64& hitStart = nextHitStart[(size_t)detector];
+                    for (juce::int64 frame = juce::jmax(blockStart, hitStart); frame < blockEnd; frame++)
+                    {
+                        if (read(frame, detector) > threshold)
+                        {
+                            hits.push_back({ frame, detector });
+                            hitStart = frame + hitDistanceSamples + 1;
+                            frame = hitStart - 1;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        //first frame of one detector above the threshold, -1 if there is none
+        juce::int64 findFirstHit(int detector, juce::int64 startFrame, juce::int64 endFrame) const
+        {
+            for (juce::int64 frame = startFrame; frame < endFrame; frame++)
+            {
+                if (read(frame, detector) > threshold)
+                    return frame;
+            }
+            return -1;
+        }
+    };
+
+    //every segment is scanned as if it started without a hit before it, then the segments are joined in order. Where the
+    //hit distance of the last hit reaches into a segment its hits are found again from there one by one, until one of them
+    //is a hit of the segment too, from that hit on the segment has the same hits as one scan over everything
+    template <MappedWavFile::SampleFormat format>
+    bool scanSegments(const NativeScanner<format>& scanner, juce::int64 lengthInSamples, juce::ThreadPool* threadPool, int numThreads,
+                      juce::int64 segmentLength, std::vector<std::pair<juce::int64, int>>& hits, const std::function<bool()>& shouldCancel)
+    {
+        int numDetectors = scanner.getNumDetectors();
+        int numSegments = (int)juce::jmax<juce::int64>(1, (lengthInSamples + segmentLength - 1) / segmentLength);
+        if (threadPool == nullptr || numThreads <= 1 || numSegments == 1)
+        {
+            std::vector<juce::int64> nextHitStart((size_t)numDetectors, 0);
+            if (!scanner.scan(0, lengthInSamples, nextHitStart, hits, shouldCancel))
+                return false;
+            std::sort(hits.begin(), hits.end());
+            return true;
+        }
+
+        //every job takes the next segment until none are left, the pool is shared so only these jobs are waited for
+        std::vector<std::vector<std::pair<juce::int64, int>>> segmentHits((size_t)numSegments);
+        std::atomic<bool> cancelled{ false };
+        std::atomic<int> nextSegment{ 0 };
+        int numJobs = juce::jmin(numThreads, threadPool->getNumThreads(), numSegments);
+        std::atomic<int> runningJobs{ numJobs };
+        juce::WaitableEvent jobsFinished;
+        for (int job = 0; job < numJobs; job++)
+        {
+            threadPool->addJob([&]()
+            {
+                for (int segment = nextSegment++; segment < numSegments && !cancelled; segment = nextSegment++)
+                {
+                    juce::int64 start = segment * segmentLength;
+                    std::vector<juce::int64> nextHitStart((size_t)numDetectors, start);
+                    if (!scanner.scan(start, juce::jmin(start + segmentLength, lengthInSamples), nextHitStart, segmentHits[(size_t)segment], shouldCancel))
+                        cancelled = true;
+                }
+                if (--runningJobs == 0)
+                    jobsFinished.signal();
+            });
+        }
+        jobsFinished.wait();
+        if (cancelled)
+            return false;
+
+        for (int detector = 0; detector < numDetectors; detector++)
+        {
+            juce::int64 nextHitStart = 0;
+            for (int segment = 0; segment < numSegments; segment++)
+            {
+                juce::int64 start = segment * segmentLength;
+                juce::int64 end = juce::jmin(start + segmentLength, lengthInSamples);
+                std::vector<juce::int64> segmentDetectorHits;
+                for (auto& [frame, hitDetector] : segmentHits[(size_t)segment])
+                {
+                    if (hitDetector == detector)
+                        segmentDetectorHits.push_back(frame);
+                }
+
+                auto next = segmentDetectorHits.begin();
+                while (nextHitStart > start)
+                {
+                    //the first hit of one scan over everything after the last hit, it can't be after the next hit of the segment
+                    next = std::lower_bound(next, segmentDetectorHits.end(), nextHitStart);
+                    bool hasNext = next != segmentDetectorHits.end();
+                    juce::int64 hit = scanner.findFirstHit(detector, nextHitStart, hasNext ? *next + 1 : end);
+                    if (hit < 0 || (hasNext && hit == *next))
+                        break; //no hits left, or the same hits as the segment from here on
+                    hits.push_back({ hit, detector });
+                    nextHitStart = hit + scanner.hitDistanceSamples + 1;
+                }
+
+                for (; next != segmentDetectorHits.end(); ++next)
+                {
+                    hits.push_back({ *next, detector });
+                    nextHitStart = *next + scanner.hitDistanceSamples + 1;
+                }
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+        return true;
+    }
+
+    //the min and max of every peak across the channels, only the min and max are converted to float
+    template <MappedWavFile::SampleFormat format>
+    void addNativePeaks(const juce::uint8* samples, int numChannels, juce::int64 lengthInSamples, PeakPyramid& peakPyramid)
+    {
+        typedef NativeSample<format> Native;
+        typedef typename Native::Type Type;
+        const int frameSize = Native::size * numChannels;
+
+        for (juce::int64 peakStart = 0; peakStart < lengthInSamples; peakStart += PeakPyramid::samplesPerPeak)
+        {
+            int numFrames = (int)juce::jmin<juce::int64>(PeakPyramid::samplesPerPeak, lengthInSamples - peakStart);
+            const juce::uint8* peakSamples = samples + peakStart * frameSize;
+            Type minimum = Native::read(peakSamples);
+            Type maximum = minimum;
+            for (int i = 1; i < numFrames * numChannels; i++)
+            {
+                Type sample = Native::read(peakSamples + i * Native::size);
+                minimum = juce::jmin(minimum, sample);
+                maximum = juce::jmax(maximum, sample);
+            }
+            peakPyramid.addPeak({ Native::toFloat(minimum), Native::toFloat(maximum) }, numFrames);
+        }
+    }
+}
+
+//==============================================================================
+
+bool MappedWavFile::open(const juce::File& wavFile)
+{
+    m_mappedFile = nullptr;
+    m_samples = nullptr;
+    if (!wavFile.hasFileExtension(".wav"))
+        return false;
+
+    auto mappedFile = std::make_unique<juce::MemoryMappedFile>(wavFile, juce::MemoryMappedFile::readOnly);
+    const juce::uint8* data = (const juce::uint8*)mappedFile->getData();
+    juce::int64 size = (juce::int64)mappedFile->getSize();
+    if (data == nullptr || size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+
+    int formatTag = 0;
+    int numChannels = 0;
+    double sampleRate = 0;
+    int bitsPerSample = 0;
+    const juce::uint8* samples = nullptr;
+    juce::int64 dataSize = 0;
+
+    //chunks are padded to an even size
+    juce::int64 position = 12;
+    while (position + 8 <= size && samples == nullptr)
+    {
+        const juce::uint8* chunk = data + position;
+        juce::int64 chunkSize = juce::ByteOrder::littleEndianInt(chunk + 4);
+        const juce::uint8* chunkData = chunk + 8;
+        juce::int64 available = size - (position + 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && chunkSize <= available)
+        {
+            formatTag = juce::ByteOrder::littleEndianShort(chunkData);
+            numChannels = juce::ByteOrder::littleEndianShort(chunkData + 2);
+            sampleRate = juce::ByteOrder::littleEndianInt(chunkData + 4);
+            bitsPerSample = juce::ByteOrder::littleEndianShort(chunkData + 14);
+            //WAVE_FORMAT_EXTENSIBLE keeps the format tag in the first two bytes of the sub format guid
+            if (formatTag == 0xfffe && chunkSize >= 40)
+                formatTag = juce::ByteOrder::littleEndianShort(chunkData + 24);
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            samples = chunkData;
+            dataSize = juce::jmin(chunkSize, available);
+        }
+        position += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    SampleFormat sampleFormat;
+    if (formatTag == 1 && bitsPerSample == 16)
+        sampleFormat = SampleFormat::int16;
+    else if (formatTag == 1 && bitsPerSample == 24)
+        sampleFormat = SampleFormat::int24;
+    else if (formatTag == 3 && bitsPerSample == 32)
+        sampleFormat = SampleFormat::float32;
+    else
+        return false;
+
+    if (samples == nullptr || numChannels <= 0 || sampleRate <= 0)
+        return false;
+
+    m_mappedFile = std::move(mappedFile);
+    m_samples = samples;
+    m_sampleFormat = sampleFormat;
+    m_numChannels = numChannels;
+    m_sampleRate = sampleRate;
+    m_lengthInSamples = dataSize / (getBytesPerSample(sampleFormat) * numChannels);
+    return true;
+}
+
+bool MappedWavFile::findHits(float dBThreshold, int hitDistanceMS, bool perChannel, std::vector<std::pair<juce::int64, int>>& hits,
+                             const std::function<bool()>& shouldCancel, juce::ThreadPool* threadPool, int numThreads) const
+{
+    if (!isOpen())
+        return false;
+    return findHits(m_samples, m_sampleFormat, m_numChannels, m_lengthInSamples, m_sampleRate, dBThreshold, hitDistanceMS, perChannel, hits,
+                    shouldCancel, threadPool, numThreads);
+}
+
+bool MappedWavFile::findHits(const juce::uint8* samples, SampleFormat sampleFormat, int numChannels, juce::int64 lengthInSamples,
+                             double sampleRate, float dBThreshold, int hitDistanceMS, bool perChannel,
+                             std::vector<std::pair<juce::int64, int>>& hits, const std::function<bool()>& shouldCancel,
+                             juce::ThreadPool* threadPool, int numThreads, juce::int64 segmentLength)
+{
+    //the same threshold gain and hit distance as AudioHitDetector
+    AudioHitDetector hitDetector(sampleRate, dBThreshold, hitDistanceMS);
+    float gain = hitDetector.getThresholdGain();
+    juce::int64 hitDistanceSamples = hitDetector.getHitDistanceSamples();
+
+    switch (sampleFormat)
+    {
+        case SampleFormat::int16:
+        {
+            NativeScanner<SampleFormat::int16> scanner{ samples, numChannels, perChannel, NativeSample<SampleFormat::int16>::getThreshold(gain), hitDistanceSamples };
+            return scanSegments(scanner, lengthInSamples, threadPool, numThreads, segmentLength, hits, shouldCancel);
+        }
+        case SampleFormat::int24:
+        {
+            NativeScanner<SampleFormat::int24> scanner{ samples, numChannels, perChannel, NativeSample<SampleFormat::int24>::getThreshold(gain), hitDistanceSamples };
+            return scanSegments(scanner, lengthInSamples, threadPool, numThreads, segmentLength, hits, shouldCancel);
+        }
+        case SampleFormat::float32:
+        {
+            NativeScanner<SampleFormat::float32> scanner{ samples, numChannels, perChannel, NativeSample<SampleFormat::float32>::getThreshold(gain), hitDistanceSamples };
+            return scanSegments(scanner, lengthInSamples, threadPool, numThreads, segmentLength, hits, shouldCancel);
+        }
+    }
+    return false;
+}
+
+void MappedWavFile::addPeaks(PeakPyramid& peakPyramid) const
+{
+    peakPyramid.reset(m_sampleRate);
+    switch (m_sampleFormat)
+    {
+        case SampleFormat::int16:
+            addNativePeaks<SampleFormat::int16>(m_samples, m_numChannels, m_lengthInSamples, peakPyramid);
+            break;
+        case SampleFormat::int24:
+            addNativePeaks<SampleFormat::int24>(m_samples, m_numChannels, m_lengthInSamples, peakPyramid);
+            break;
+        case SampleFormat::float32:
+            addNativePeaks<SampleFormat::float32>(m_samples, m_numChannels, m_lengthInSamples, peakPyramid);
+            break;
+    }
+    peakPyramid.finish();
+}
+
+//==============================================================================
+
+BenchmarkResult MappedWavFile::benchmark(int numSeconds)
+{
+    double sampleRate = 48000;
+    int numChannels = 2;
+    int numSamples = (int)(numSeconds * sampleRate);
+    juce::Random random(numSeconds);
+
+    //the same decaying hits as AudioHitDetector::benchmark, on both channels
+    juce::AudioBuffer<float> audio(numChannels, numSamples);
+    BenchmarkHits hits;
+    hits.sampleRate = sampleRate;
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        hits.firstHit = channel * 997;
+        hits.generate(audio.getWritePointer(channel), numSamples, random);
+    }
+
+    juce::String output = "MappedWavFile::benchmark " + juce::String(numSeconds) + " s of random hits on " + juce::String(numChannels) + " channels\n";
+    const float dBThreshold = -20;
+    const int hitDistanceMS = 50;
+    int numFailed = 0;
+    for (SampleFormat sampleFormat : { SampleFormat::int16, SampleFormat::int24, SampleFormat::float32 })
+    {
+        //the samples as they are stored in the data chunk, and converted back to float the way the wav reader does
+        int bytesPerSample = getBytesPerSample(sampleFormat);
+        juce::HeapBlock<juce::uint8> data((size_t)numSamples * numChannels * bytesPerSample);
+        juce::AudioBuffer<float> decoded(numChannels, numSamples);
+        for (int i = 0; i < numSamples; i++)
+        {
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                float sample = audio.getSample(channel, i);
+                juce::uint8* stored = data + ((size_t)i * numChannels + channel) * bytesPerSample;
+                if (sampleFormat == SampleFormat::int16)
+                {
+                    auto value = (juce::int16)juce::jlimit(-32768, 32767, juce::roundToInt(sample * 32768));
+                    stored[0] = (juce::uint8)(value & 0xff);
+                    stored[1] = (juce::uint8)((value >> 8) & 0xff);
+                    decoded.setSample(channel, i, value / 32768.f);
+                }
+                else if (sampleFormat == SampleFormat::int24)
+                {
+                    int value = juce::jlimit(-8388608, 8388607, juce::roundToInt(sample * 8388608));
+                    stored[0] = (juce::uint8)(value & 0xff);
+                    stored[1] = (juce::uint8)((value >> 8) & 0xff);
+                    stored[2] = (juce::uint8)((value >> 16) & 0xff);
+                    decoded.setSample(channel, i, value / 8388608.f);
+                }
+                else
+                {
+                    juce::uint32 bits;
+                    std::memcpy(&bits, &sample, sizeof(float));
+                    for (int b = 0; b < 4; b++)
+                        stored[b] = (juce::uint8)((bits >> (8 * b)) & 0xff);
+                    decoded.setSample(channel, i, sample);
+                }
+            }
+        }
+
+        juce::String name = sampleFormat == SampleFormat::int16 ? "int16" : sampleFormat == SampleFormat::int24 ? "int24" : "float32";
+        for (bool perChannel : { false, true })
+        {
+            juce::String mode = name + (perChannel ? " per channel" : "");
+            TimerBench timerBench;
+            std::vector<std::pair<juce::int64, int>> hits;
+            findHits(data, sampleFormat, numChannels, numSamples, sampleRate, dBThreshold, hitDistanceMS, perChannel, hits);
+            output += timerBench.StopAndGetTime(mode + " findHits (us)") + "\n";
+
+            timerBench.Start();
+            std::vector<std::pair<juce::int64, int>> floatHits;
+            for (int detector = 0; detector < (perChannel ? numChannels : 1); detector++)
+            {
+                AudioHitDetector hitDetector(sampleRate, dBThreshold, hitDistanceMS);
+                juce::Array<juce::int64> hitSamples;
+                const float* const* channels = decoded.getArrayOfReadPointers() + (perChannel ? detector : 0);
+                hitDetector.process(channels, perChannel ? 1 : numChannels, numSamples, hitSamples);
+                for (juce::int64 sample : hitSamples)
+                    floatHits.push_back({ sample, detector });
+            }
+            std::sort(floatHits.begin(), floatHits.end());
+            output += timerBench.StopAndGetTime(mode + " AudioHitDetector on float (us)") + "\n";
+
+            int mismatches = (int)std::abs((juce::int64)hits.size() - (juce::int64)floatHits.size());
+            for (size_t i = 0; i < juce::jmin(hits.size(), floatHits.size()); i++)
+            {
+                if (hits[i] != floatHits[i])
+                    mismatches++;
+            }
+            output += mode + " hits: " + juce::String((int)hits.size()) + ", mismatches: " + juce::String(mismatches) + "\n";
+            numFailed += mismatches;
+        }
+    }
+    return { output, numFailed };
+}
+
+BenchmarkResult MappedWavFile::benchmark(const juce::File& wavFile, float dBThreshold, int hitDistanceMS)
+{
+    juce::String output = "MappedWavFile::benchmark " + wavFile.getFileName() + "\n";
+
+    TimerBench timerBench;
+    MappedWavFile mappedWavFile;
+    std::vector<std::pair<juce::int64, int>> hits;
+    if (!mappedWavFile.open(wavFile) || !mappedWavFile.findHits(dBThreshold, hitDistanceMS, false, hits))
+        return { output + "Can't map " + wavFile.getFileName() + ", only 16 and 24 bit pcm and 32 bit float wav files are mapped\n", 1 };
+    output += timerBench.StopAndGetTime("mapped findHits (us)") + "\n";
+
+    //the streaming read of AnalysisCore::readAudioFile
+    timerBench.Start();
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(wavFile));
+    if (reader == nullptr)
+        return { output + "Can't read " + wavFile.getFileName() + "\n", 1 };
+
+    AudioHitDetector hitDetector(reader->sampleRate, dBThreshold, hitDistanceMS);
+    juce::Array<juce::int64> readerHits;
+    juce::AudioBuffer<float> block(juce::jmax(1, (int)reader->numChannels), AudioHitDetector::blockSize);
+    for (juce::int64 position = 0; position < reader->lengthInSamples; position += AudioHitDetector::blockSize)
+    {
+        int numSamples = (int)juce::jmin<juce::int64>(AudioHitDetector::blockSize, reader->lengthInSamples - position);
+        reader->read(&block, 0, numSamples, position, true, true);
+        hitDetector.process(block.getArrayOfReadPointers(), block.getNumChannels(), numSamples, readerHits);
+    }
+    output += timerBench.StopAndGetTime("AudioFormatReader and AudioHitDetector (us)") + "\n";
+
+    int mismatches = std::abs((int)hits.size() - readerHits.size());
+    for (int i = 0; i < juce::jmin((int)hits.size(), readerHits.size()); i++)
+    {
+        if (hits[(size_t)i].first != readerHits[i])
+            mismatches++;
+    }
+    output += "hits: " + juce::String((int)hits.size()) + ", mismatches: " + juce::String(mismatches) + "\n";
+    return { output, mismatches };
+}
+
+BenchmarkResult MappedWavFile::benchmarkThreads(int numSeconds)
+{
+    double sampleRate = 48000;
+    int numChannels = 2;
+    juce::int64 numSamples = (juce::int64)(numSeconds * sampleRate);
+    juce::Random random(numSeconds);
+
+    //16 bit hits with a short decay and a noise floor, some of them closer than the hit distance
+    juce::HeapBlock<juce::uint8> data((size_t)numSamples * numChannels * 2);
+    juce::HeapBlock<float> samples((size_t)numSamples);
+    BenchmarkHits hits;
+    hits.sampleRate = sampleRate;
+    hits.minSecondsApart = 0.01;
+    hits.maxSecondsApart = 0.31;
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        hits.firstHit = channel * 997;
+        hits.generate(samples, numSamples, random);
+        for (juce::int64 i = 0; i < numSamples; i++)
+        {
+            auto value = (juce::int16)juce::roundToInt(samples[i] * 32767);
+            juce::uint8* stored = data + ((size_t)i * numChannels + channel) * 2;
+            stored[0] = (juce::uint8)(value & 0xff);
+            stored[1] = (juce::uint8)((value >> 8) & 0xff);
+        }
+    }
+
+    juce::String output = "MappedWavFile::benchmarkThreads " + juce::String(numSeconds) + " s on " + juce::String(numChannels) + " channels\n";
+    const float dBThreshold = -20;
+    //one pool for every run like the pool of the decoder
+    juce::ThreadPool threadPool(16);
+    auto findAll = [&](int hitDistanceMS, bool perChannel, int numThreads, juce::int64 segmentLength)
+    {
+        std::vector<std::pair<juce::int64, int>> hits;
+        findHits(data, SampleFormat::int16, numChannels, numSamples, sampleRate, dBThreshold, hitDistanceMS, perChannel, hits,
+                 nullptr, &threadPool, numThreads, segmentLength);
+        return hits;
+    };
+
+    //segments shorter than the hit distance make the stitching go over whole segments
+    int mismatches = 0;
+    int numCompared = 0;
+    for (int hitDistanceMS : { 50, 2000 })
+    {
+        for (bool perChannel : { false, true })
+        {
+            auto serialHits = findAll(hitDistanceMS, perChannel, 1, defaultSegmentLength);
+            for (juce::int64 segmentLength : { defaultSegmentLength, (juce::int64)4096, (juce::int64)1000, (juce::int64)7 })
+            {
+                for (int numThreads : { 2, 4, 8, 16 })
+                {
+                    for (int run = 0; run < 2; run++)
+                    {
+                        if (findAll(hitDistanceMS, perChannel, numThreads, segmentLength) != serialHits)
+                            mismatches++;
+                        numCompared++;
+                    }
+                }
+            }
+        }
+    }
+    output += "runs that differ from one thread: " + juce::String(mismatches) + " of " + juce::String(numCompared) + "\n";
+
+    for (bool perChannel : { false, true })
+    {
+        double serialTime = 0;
+        for (int numThreads : { 1, 2, 4, 8, 16 })
+        {
+            double start = juce::Time::getMillisecondCounterHiRes();
+            findAll(50, perChannel, numThreads, defaultSegmentLength);
+            double time = (juce::Time::getMillisecondCounterHiRes() - start) * 1000;
+            if (numThreads == 1)
+                serialTime = time;
+            output += juce::String(perChannel ? "per channel, " : "") + juce::String(numThreads) + " threads: " + juce::String(time, 0)
+                    + " us, speedup " + juce::String(serialTime / juce::jmax(1.0, time), 2) + "\n";
+        }
+    }
+    return { output, mismatches };
+}
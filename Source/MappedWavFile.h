@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Globals.h"
+#include "AudioHitDetector.h"
+#include "PeakPyramid.h"
+#include <vector>
+
+//==============================================================================
+//an uncompressed .wav take read through a memory map, the amplitude hit detection runs on the native samples
+//of the data chunk so nothing is decoded or copied. Gives the same hits as AudioHitDetector on the samples
+//converted to float the way juce::WavAudioFormat does
+class MappedWavFile
+{
+public:
+    enum class SampleFormat
+    {
+        int16,
+        int24,
+        float32
+    };
+
+    MappedWavFile() {}
+
+    //false for compressed or other sample formats, those have to go through an AudioFormatReader
+    bool open(const juce::File& wavFile);
+    bool isOpen() const { return m_samples != nullptr; }
+
+    double getSampleRate() const { return m_sampleRate; }
+    int getNumChannels() const { return m_numChannels; }
+    juce::int64 getLengthInSamples() const { return m_lengthInSamples; }
+    SampleFormat getSampleFormat() const { return m_sampleFormat; }
+
+    //adds the sample and channel of every hit, on the peak of all channels (channel 0) or on every channel by itself.
+    //With a pool and more than one thread the take is split into segments that up to numThreads jobs of the pool scan
+    //at the same time, the hits are the same. Returns false if shouldCancel stopped it
+    bool findHits(float dBThreshold, int hitDistanceMS, bool perChannel, std::vector<std::pair<juce::int64, int>>& hits,
+                  const std::function<bool()>& shouldCancel = nullptr, juce::ThreadPool* threadPool = nullptr, int numThreads = 1) const;
+
+    //builds the pyramid of the whole take from the native samples
+    void addPeaks(PeakPyramid& peakPyramid) const;
+
+    //findHits on interleaved little endian samples
+    static bool findHits(const juce::uint8* samples, SampleFormat sampleFormat, int numChannels, juce::int64 lengthInSamples,
+                         double sampleRate, float dBThreshold, int hitDistanceMS, bool perChannel,
+                         std::vector<std::pair<juce::int64, int>>& hits, const std::function<bool()>& shouldCancel = nullptr,
+                         juce::ThreadPool* threadPool = nullptr, int numThreads = 1, juce::int64 segmentLength = defaultSegmentLength);
+
+    //samples of every channel in a segment that one thread scans
+    inline static const juce::int64 defaultSegmentLength = 1 << 20;
+
+    //times findHits on random audio in every sample format against AudioHitDetector on the same samples as float,
+    //or times an audio file against reading it through an AudioFormatReader. Every hit where they disagree fails
+    static BenchmarkResult benchmark(int numSeconds);
+    static BenchmarkResult benchmark(const juce::File& wavFile, float dBThreshold, int hitDistanceMS);
+    //compares findHits on 2 to 16 threads against one thread, also on tiny segments so the hit distance
+    //often reaches over many segments. Every run that differs from one thread fails
+    static BenchmarkResult benchmarkThreads(int numSeconds);
+
+    static int getBytesPerSample(SampleFormat sampleFormat) { return sampleFormat == SampleFormat::int16 ? 2 : sampleFormat == SampleFormat::int24 ? 3 : 4; }
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> m_mappedFile;
+    const juce::uint8* m_samples = nullptr;
+    SampleFormat m_sampleFormat = SampleFormat::int16;
+    int m_numChannels = 0;
+    double m_sampleRate = 0;
+    juce::int64 m_lengthInSamples = 0;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedWavFile)
+};
@@ -29,7 +29,13 @@ void MidiDisplay::paint(juce::Graphics& g)
 	for (int i = 0; i <= beatRange * m_beatSubDivisions; i++)
 	{
 		float lineThickness;
-		if (i % (timeSignature.numerator * m_beatSubDivisions) == 0) //first beat in the measure
+		bool isMeasureStart = i % (timeSignature.numerator * m_beatSubDivisions) == 0;
+		if (m_tempoMap != nullptr)
+		{
+			double measure = m_tempoMap->tickToMeasure((m_beatStart + (double)i / m_beatSubDivisions) * g_defaultQuarterNoteTicks);
+			isMeasureStart = std::abs(measure - std::round(measure)) < 1e-6;
+		}
+		if (isMeasureStart) //first beat in the measure
 			lineThickness = 3.f;
 		else if (i % m_beatSubDivisions == 0)
 			lineThickness = 2.f;
@@ -42,8 +48,14 @@ void MidiDisplay::paint(juce::Graphics& g)
 		g.drawLine(beatPosition, 0, beatPosition, getHeight(), lineThickness);
 	}
 
+	//the notes are drawn above the waveform lane
+	bool hasWaveform = m_waveform != nullptr && !m_waveform->isEmpty();
+	int notesHeight = getHeight() - (hasWaveform ? waveformLaneHeight : 0);
+	if (hasWaveform)
+		paintWaveform(g, getLocalBounds().removeFromBottom(waveformLaneHeight), beatRange, displayWidth, displayOffset);
+
 	int noteRangeDistance = (m_highestNote - m_lowestNote + 1);
-	float noteDisplayHeight = getHeight() / noteRangeDistance;
+	float noteDisplayHeight = notesHeight / noteRangeDistance;
 
 	//quantized midi hits
 	g.setColour(quantizedColor);
@@ -57,19 +69,42 @@ void MidiDisplay::paint(juce::Graphics& g)
 		g.fillRect(startTimePosition, pitchPosition, noteDisplayWidth, noteDisplayHeight);
 	}
 
+	//quantized midi hits that were not played
+	g.setColour(missedColor);
+	for (int missedIndex : m_missedQuantizedIndices)
+	{
+		const MidiEvent& midi = m_quantizedMidi.getReference(missedIndex);
+		float relativeBeat = midi.tickStart / midi.quarterNoteTicks - m_beatStart;
+
+		float startTimePosition = relativeBeat / beatRange * displayWidth + displayOffset;
+		float pitchPosition = (m_highestNote - midi.note) * noteDisplayHeight;
+		g.drawRect(startTimePosition - analyzedNoteDisplayWidth / 2, pitchPosition, analyzedNoteDisplayWidth * 2, noteDisplayHeight);
+	}
+
 	//analyze midi hits
 	for (const MidiEvent& midi : m_analyzedMidi)
 	{
 		//relative to record start
 		double tickStart = midi.tickStart + getRecordTickStart(midi.quarterNoteTicks);
-		double msStart = MidiEvent::getMiliseconds(tickStart, m_bpm, midi.quarterNoteTicks);
+
+		//relative to the display range rather than the midi file
+		float relativeBeat = tickStart / midi.quarterNoteTicks - m_beatStart;
+		float startTimePosition = relativeBeat / beatRange * displayWidth + displayOffset;
 
 		if (midi.closestQuantizedIndex < 0 || midi.closestQuantizedIndex >= m_quantizedMidi.size())
+		{
+			if (m_oneToOneAlignment) //extra hit
+			{
+				g.setColour(extraColor);
+				if (midi.useQuantizedNote) //no pitch to show it at
+					g.fillRect(startTimePosition, 0.f, noteDisplayWidth, (float)notesHeight);
+				else
+					g.fillRect(startTimePosition, (m_highestNote - midi.note) * noteDisplayHeight, analyzedNoteDisplayWidth, noteDisplayHeight);
+			}
 			continue;
-		MidiEvent& quantizedMidi = m_quantizedMidi[midi.closestQuantizedIndex];
-		double quantizedMSStart = MidiEvent::getMiliseconds(quantizedMidi.tickStart, m_bpm, quantizedMidi.quarterNoteTicks);
-
-		double msDifference = msStart - quantizedMSStart;
+		}
+		const MidiEvent& quantizedMidi = m_quantizedMidi.getReference(midi.closestQuantizedIndex);
+		double msDifference = getMSDeviation(midi, quantizedMidi);
 		if (std::abs(msDifference) <= m_msTimeThreshold)
 			g.setColour(onTimeColor);
 		else if (msDifference > 0) //late
@@ -77,14 +112,76 @@ void MidiDisplay::paint(juce::Graphics& g)
 		else //early
 			g.setColour(earlyColor);
 
-		//relative to the display range rather than the midi file
-		float relativeBeat = tickStart / midi.quarterNoteTicks - m_beatStart;
-
-		float startTimePosition = relativeBeat / beatRange * displayWidth + displayOffset;
 		int note = midi.useQuantizedNote ? quantizedMidi.note : midi.note;
 		float pitchPosition = (m_highestNote - note) * noteDisplayHeight;
 		g.fillRect(startTimePosition, pitchPosition, analyzedNoteDisplayWidth, noteDisplayHeight);
 	}
+
+	//summary strip, the live score is already summed up by the processor
+	juce::String summary;
+	if (m_showLiveScore)
+	{
+		summary = m_liveScore.toString();
+	}
+	else
+	{
+		if (m_timingStatisticsDirty)
+			updateTimingStatistics();
+		if (!m_timingStatistics.isEmpty())
+			summary = m_timingStatistics.total.toString();
+	}
+	if (summary.isNotEmpty())
+	{
+		Bounds summaryBounds = getLocalBounds().removeFromTop(summaryStripHeight);
+		g.setColour(g_defaultEditorColor.withAlpha(0.8f));
+		g.fillRect(summaryBounds);
+		g.setColour(juce::Colours::white);
+		g.setFont(getMonoFont(summaryStripHeight - 4.f));
+		g.drawText(summary, summaryBounds.reduced(4, 0), juce::Justification::centredLeft, true);
+	}
+}
+
+void MidiDisplay::paintWaveform(juce::Graphics& g, Bounds laneBounds, double beatRange, int displayWidth, int displayOffset)
+{
+	g.setColour(g_defaultEditorColor.withAlpha(0.6f));
+	g.fillRect(laneBounds);
+
+	//the level with about one peak per pixel, so the lane costs the same at any zoom
+	double samplesPerBeat = 60.0 / (m_tempoMap != nullptr ? m_tempoMap->getBpm(m_beatStart * g_defaultQuarterNoteTicks) : m_bpm) * m_waveform->getSampleRate();
+	//the first sample is at the record start, through the tempo changes with a map
+	double recordMSStart = m_tempoMap != nullptr ? m_tempoMap->tickToMS(getRecordTickStart((int)g_defaultQuarterNoteTicks)) : 0;
+	auto getSample = [&](double beat)
+	{
+		if (m_tempoMap == nullptr)
+			return (juce::int64)std::floor(beat * samplesPerBeat);
+		double ms = m_tempoMap->tickToMS((beat + getRecordBeatStart()) * g_defaultQuarterNoteTicks) - recordMSStart;
+		return (juce::int64)std::floor(ms / 1000 * m_waveform->getSampleRate());
+	};
+	double beatsPerPixel = beatRange / displayWidth;
+	int level = m_waveform->getLevel(beatsPerPixel * samplesPerBeat);
+
+	float centre = (float)laneBounds.getCentreY();
+	float halfHeight = laneBounds.getHeight() / 2.f;
+	g.setColour(waveformColor);
+	for (int x = laneBounds.getX(); x < laneBounds.getRight(); x++)
+	{
+		//relative to the record start like the analyzed hits
+		double beat = (x - displayOffset) * beatsPerPixel + m_beatStart - getRecordBeatStart();
+		juce::int64 startSample = getSample(beat);
+		juce::int64 endSample = juce::jmax(startSample + 1, getSample(beat + beatsPerPixel));
+		if (endSample <= 0 || startSample >= m_waveform->getLengthInSamples())
+			continue;
+
+		juce::Range<float> range = m_waveform->getRange(level, juce::jmax<juce::int64>(0, startSample), endSample);
+		float top = centre - juce::jlimit(-1.f, 1.f, range.getEnd()) * halfHeight;
+		float bottom = centre - juce::jlimit(-1.f, 1.f, range.getStart()) * halfHeight;
+		g.drawVerticalLine(x, top, juce::jmax(bottom, top + 1));
+	}
+
+	g.setColour(waveformThresholdColor);
+	float thresholdHeight = juce::jmin(1.f, m_waveformThresholdGain) * halfHeight;
+	g.drawHorizontalLine((int)(centre - thresholdHeight), (float)laneBounds.getX(), (float)laneBounds.getRight());
+	g.drawHorizontalLine((int)(centre + thresholdHeight), (float)laneBounds.getX(), (float)laneBounds.getRight());
 }
 
 void MidiDisplay::resized()
@@ -114,6 +211,8 @@ void MidiDisplay::setQuantizedMidi(const vArray<MidiEvent>& newQuantizedMidi)
 	m_lowestNote -= 1; //padding
 	m_highestNote += 1; //padding
 	m_quantizedBeatRange = std::ceil(lastTick / m_quantizedMidi[0].quarterNoteTicks);
+	m_matcher.setReference(m_quantizedMidi);
+	m_matchVersion++;
 
 	updateAnalyzedMidi();
 }
@@ -124,44 +223,153 @@ void MidiDisplay::setAnalyzedMidi(const vArray<MidiEvent>& newAnalyzedMidi)
 	updateAnalyzedMidi();
 }
 
+void MidiDisplay::setAnalyzedTake(const AnalyzedTake& analyzedTake)
+{
+	m_analyzedMidi = analyzedTake.analyzedMidi;
+	if (analyzedTake.matchVersion != m_matchVersion)
+	{
+		updateAnalyzedMidi();
+		return;
+	}
+
+	m_matcher = analyzedTake.matcher;
+	m_missedQuantizedIndices = analyzedTake.missedQuantizedIndices;
+	m_matchedRecordBeatStart = analyzedTake.recordBeatStart;
+	m_timingStatisticsDirty = true;
+	//the record start can move while the take is analyzed
+	updateRecordStart();
+}
+
+void MidiDisplay::addAnalyzedMidi(const vArray<MidiEvent>& newAnalyzedMidi)
+{
+	int numMatched = m_analyzedMidi.size();
+	m_analyzedMidi.addArray(newAnalyzedMidi);
+	//the one-to-one alignment can move earlier matches, closest matching only has to match the new hits
+	if (m_oneToOneAlignment || getRecordBeatStart() != m_matchedRecordBeatStart || m_matcher.getNumAnalyzed() != numMatched)
+	{
+		updateAnalyzedMidi();
+		return;
+	}
+
+	m_timingStatisticsDirty = true;
+	m_matcher.addAnalyzed(m_analyzedMidi, m_matchedRecordBeatStart);
+	repaint();
+}
+
 void MidiDisplay::updateAnalyzedMidi()
 {
-	for (MidiEvent& midi : m_analyzedMidi)
+	m_missedQuantizedIndices.clear();
+	m_timingStatisticsDirty = true;
+	m_matchedRecordBeatStart = getRecordBeatStart();
+	if (m_oneToOneAlignment)
 	{
-		//relative to the record start
-		double tickStart = midi.tickStart + getRecordTickStart(midi.quarterNoteTicks);
+		double toleranceTicks = MidiEvent::getTick(m_msAlignmentWindow, m_bpm, g_defaultQuarterNoteTicks);
+		MidiMatcher::Alignment alignment = m_matcher.alignOneToOne(m_analyzedMidi, m_matchedRecordBeatStart, toleranceTicks);
+		m_missedQuantizedIndices = alignment.missedQuantizedIndices;
+	}
+	else
+	{
+		m_matcher.setAnalyzed(m_analyzedMidi, m_matchedRecordBeatStart);
+	}
 
-		double lowestDifference = tickStart - m_quantizedMidi[0].getTickStart(midi.quarterNoteTicks);
-		int closestQuantizedIndex = 0;
-		for (int i = 1; i < m_quantizedMidi.size(); i++)
-		{
-			if (std::abs(tickStart - m_quantizedMidi[i].getTickStart(midi.quarterNoteTicks)) < std::abs(lowestDifference))
-			{
-				lowestDifference = tickStart - m_quantizedMidi[i].getTickStart(midi.quarterNoteTicks);
-				closestQuantizedIndex = i;
-			}
-		}
-		midi.closestQuantizedIndex = closestQuantizedIndex;
+	repaint();
+}
+
+void MidiDisplay::updateRecordStart()
+{
+	double recordBeatStart = getRecordBeatStart();
+	if (recordBeatStart == m_matchedRecordBeatStart)
+	{
+		repaint(); //only the range changed, the matches are the same
+		return;
+	}
+
+	if (m_oneToOneAlignment)
+	{
+		updateAnalyzedMidi();
+		return;
 	}
 
+	//every analyzed hit moves by the same amount
+	m_timingStatisticsDirty = true;
+	m_matchedRecordBeatStart = recordBeatStart;
+	m_matcher.shiftRecordStart(m_analyzedMidi, recordBeatStart);
 	repaint();
 }
 
+double MidiDisplay::getMSDeviation(const MidiEvent& midi, const MidiEvent& quantizedMidi) const
+{
+	return AnalysisCore::getMSDeviation(midi, quantizedMidi, getRecordBeatStart(), m_bpm, m_tempoMap.get());
+}
+
+const TimingStatistics& MidiDisplay::getTimingStatistics()
+{
+	if (m_timingStatisticsDirty)
+		updateTimingStatistics();
+	return m_timingStatistics;
+}
+
+void MidiDisplay::updateTimingStatistics()
+{
+	AnalysisSettings settings;
+	settings.bpm = m_bpm;
+	settings.timeSignatureNumerator = timeSignature.numerator;
+	settings.recordBeatStart = getRecordBeatStart();
+	settings.msTimeThreshold = m_msTimeThreshold;
+	settings.tempoMap = m_tempoMap;
+	AnalysisCore::getTimingStatistics(m_analyzedMidi, m_quantizedMidi, settings, m_timingStatistics);
+	m_timingStatisticsDirty = false;
+}
+
 void MidiDisplay::clearAnalyzedMidi(bool repaintMidi)
 {
 	m_analyzedMidi.clear();
+	m_matcher.setAnalyzed(m_analyzedMidi, getRecordBeatStart());
+	m_missedQuantizedIndices.clear();
+	m_timingStatisticsDirty = true;
+	if (repaintMidi)
+		repaint();
+}
+
+void MidiDisplay::setLiveScore(const LiveScore* liveScore, bool repaintMidi)
+{
+	m_showLiveScore = liveScore != nullptr;
+	if (liveScore != nullptr)
+		m_liveScore = *liveScore;
 	if (repaintMidi)
 		repaint();
 }
 
+void MidiDisplay::setWaveform(std::shared_ptr<const PeakPyramid> waveform, bool repaintMidi)
+{
+	m_waveform = std::move(waveform);
+	if (repaintMidi)
+		repaint();
+}
+
+void MidiDisplay::setWaveformThreshold(float gain, bool repaintMidi)
+{
+	m_waveformThresholdGain = gain;
+	if (repaintMidi && m_waveform != nullptr)
+		repaint();
+}
+
 void MidiDisplay::setBpm(double bpm, bool repaintMidi)
 {
 	if (bpm < 0)
 		return; //not valid
 
+	if (bpm != m_bpm)
+		m_matchVersion++;
 	m_bpm = bpm;
+	m_timingStatisticsDirty = true;
 	if (repaintMidi)
-		repaint();
+	{
+		if (m_oneToOneAlignment) //the alignment window is in ms
+			updateAnalyzedMidi();
+		else
+			repaint();
+	}
 }
 
 void MidiDisplay::setTimeThreshold(double ms, bool repaintMidi)
@@ -170,25 +378,75 @@ void MidiDisplay::setTimeThreshold(double ms, bool repaintMidi)
 		return; //not valid
 
 	m_msTimeThreshold = ms;
+	m_timingStatisticsDirty = true;
 	if (repaintMidi)
 		repaint();
 }
 
-void MidiDisplay::setMeasureRange(double measureStart, double length, bool repaintMidi)
+void MidiDisplay::setAlignmentMode(bool oneToOne, double msWindow, bool repaintMidi)
 {
-	m_beatStart = measureStart * timeSignature.numerator;
-	m_beatEnd = (measureStart + length) * timeSignature.numerator;
+	if (msWindow < 0)
+		return; //not valid
+
+	if (oneToOne != m_oneToOneAlignment || msWindow != m_msAlignmentWindow)
+		m_matchVersion++;
+	m_oneToOneAlignment = oneToOne;
+	m_msAlignmentWindow = msWindow;
 	if (repaintMidi)
 		updateAnalyzedMidi();
 }
 
-void MidiDisplay::setRecordStart(double measure, bool repaintMidi)
+void MidiDisplay::setPitchGroups(const juce::Array<juce::Array<int>>& pitchGroups, bool repaintMidi)
 {
-	m_recordBeatStart = measure * timeSignature.numerator;
+	m_matcher.setPitchGroups(pitchGroups);
+	m_matchVersion++;
 	if (repaintMidi)
 		updateAnalyzedMidi();
 }
 
+void MidiDisplay::setMeasureRange(double measureStart, double length, bool repaintMidi)
+{
+	m_measureStart = measureStart;
+	m_measureLength = length;
+	updateBeatRange();
+	if (repaintMidi)
+		updateRecordStart();
+}
+
+void MidiDisplay::setRecordStart(double measure, bool repaintMidi)
+{
+	m_recordStartMeasure = measure;
+	updateBeatRange();
+	if (repaintMidi)
+		updateRecordStart();
+}
+
+void MidiDisplay::setTempoMap(std::shared_ptr<const TempoMap> tempoMap, bool repaintMidi)
+{
+	m_tempoMap = std::move(tempoMap);
+	m_timingStatisticsDirty = true;
+	updateBeatRange();
+	if (repaintMidi)
+		updateRecordStart();
+}
+
+void MidiDisplay::updateBeatRange()
+{
+	m_beatStart = getMeasureBeat(m_measureStart);
+	m_beatEnd = getMeasureBeat(m_measureStart + m_measureLength);
+	if (m_tempoMap != nullptr)
+		m_recordBeatStart = getMeasureBeat(m_measureStart + m_recordStartMeasure) - m_beatStart;
+	else
+		m_recordBeatStart = m_recordStartMeasure * timeSignature.numerator;
+}
+
+double MidiDisplay::getMeasureBeat(double measure) const
+{
+	if (m_tempoMap != nullptr)
+		return m_tempoMap->measureToTick(measure) / g_defaultQuarterNoteTicks;
+	return measure * timeSignature.numerator;
+}
+
 juce::String MidiDisplay::debugMidiDisplay()
 {
 	juce::String output = "MidiDisplay:\n";
@@ -216,6 +474,10 @@ juce::String MidiDisplay::debugMidiDisplay()
 	output += "m_lowestNote: " + juce::String(m_lowestNote) + "\n";
 	output += "m_highestNote: " + juce::String(m_highestNote) + "\n";
 	output += "m_msTimeThreshold: " + juce::String(m_msTimeThreshold) + "\n";
+	output += "m_oneToOneAlignment: " + juce::String((int)m_oneToOneAlignment) + "\n";
+	output += "m_msAlignmentWindow: " + juce::String(m_msAlignmentWindow) + "\n";
+	output += "m_missedQuantizedIndices: " + juce::String(m_missedQuantizedIndices.size()) + "\n";
+	output += getTimingStatistics().debugTimingStatistics();
 	output += "noteDisplayWidth: " + juce::String(noteDisplayWidth) + "\n";
 	output += "analyzedNoteDisplayWidth: " + juce::String(analyzedNoteDisplayWidth) + "\n";
 
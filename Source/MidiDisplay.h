@@ -2,6 +2,11 @@
 
 #include "Globals.h"
 #include "MidiEvent.h"
+#include "MidiMatcher.h"
+#include "TimingStatistics.h"
+#include "AnalysisCore.h"
+#include "LiveScore.h"
+#include "AnalysisWorker.h"
 
 extern const double g_defaultQuarterNoteTicks;
 
@@ -17,19 +22,54 @@ public:
     //==============================================================================
     void setQuantizedMidi(const vArray<MidiEvent>& newQuantizedMidi);
     void setAnalyzedMidi(const vArray<MidiEvent>& newAnalyzedMidi);
+    //adds hits to the analyzed midi, for hits that arrive while the take is played
+    void addAnalyzedMidi(const vArray<MidiEvent>& newAnalyzedMidi);
     void updateAnalyzedMidi();
+    //takes the matches of a take that was matched by an AnalysisWorker, the take is only matched again if the
+    //reference or a match setting changed since it was requested
+    void setAnalyzedTake(const AnalyzedTake& analyzedTake);
+    //changes with the reference, pitch groups, alignment mode and bpm, never 0
+    juce::uint32 getMatchVersion() const { return m_matchVersion; }
     void clearAnalyzedMidi(bool repaintMidi);
+    //matched to the quantized midi
+    const vArray<MidiEvent>& getAnalyzedMidi() const { return m_analyzedMidi; }
+    //quantized notes without a hit, only in one-to-one alignment mode
+    int getNumMissed() const { return m_missedQuantizedIndices.size(); }
+
+    //shown in the summary strip instead of the timing statistics of the analyzed midi, nullptr shows those again
+    void setLiveScore(const LiveScore* liveScore, bool repaintMidi);
+
+    //waveform of the audio take in a lane under the notes, its first sample is at the record start. nullptr removes the lane
+    void setWaveform(std::shared_ptr<const PeakPyramid> waveform, bool repaintMidi);
+    //gain of the audio hit threshold, drawn on the waveform so it shows why a hit was or wasn't found
+    void setWaveformThreshold(float gain, bool repaintMidi);
 
     void setBpm(double bpm, bool repaintMidi);
+    //tempo and meter changes of the quantized midi for the measure grid, measures and deviations, nullptr uses bpm
+    //and timeSignature from the start
+    void setTempoMap(std::shared_ptr<const TempoMap> tempoMap, bool repaintMidi);
     //set threshold for when a midi note is considered "on time" and not late or early
     void setTimeThreshold(double ms, bool repaintMidi);
 
+    //match every analyzed hit to at most one quantized note within msWindow and show missed and extra notes,
+    //otherwise every hit is matched to its closest quantized note
+    void setAlignmentMode(bool oneToOne, double msWindow, bool repaintMidi);
+
+    //pitches in the same group are matched to each other, see MidiMatcher::setPitchGroups
+    void setPitchGroups(const juce::Array<juce::Array<int>>& pitchGroups, bool repaintMidi);
+
     //the measures that the midi display should show
     void setMeasureRange(double measureStart, double length, bool repaintMidi);
     //relative to measure start
     void setRecordStart(double measure, bool repaintMidi);
     //retruns the absolute tick start
-    double getRecordTickStart(int quarterNoteTicks) { return (m_beatStart + m_recordBeatStart) * quarterNoteTicks; }
+    double getRecordTickStart(int quarterNoteTicks) const { return getRecordBeatStart() * quarterNoteTicks; }
+    double getRecordBeatStart() const { return m_beatStart + m_recordBeatStart; }
+
+    //signed ms that an analyzed hit is off from its quantized note, positive when late
+    double getMSDeviation(const MidiEvent& midi, const MidiEvent& quantizedMidi) const;
+    //timing of the matched hits, only recalculated after the matches, bpm or time threshold changed
+    const TimingStatistics& getTimingStatistics();
 
     //==============================================================================
     juce::String debugMidiDisplay();
@@ -39,27 +79,63 @@ public:
     juce::AudioPlayHead::TimeSignature timeSignature;
 
 private:
+    void updateTimingStatistics();
+    void paintWaveform(juce::Graphics& g, Bounds laneBounds, double beatRange, int displayWidth, int displayOffset);
+
+    //applies a changed record or measure start without matching the analyzed midi again
+    void updateRecordStart();
+    //beats of the measure range and record start from the measures they were set with
+    void updateBeatRange();
+    //absolute beat that measure starts at
+    double getMeasureBeat(double measure) const;
+
     vArray<MidiEvent> m_quantizedMidi;
     vArray<MidiEvent> m_analyzedMidi;
+    MidiMatcher m_matcher;
+    juce::uint32 m_matchVersion = 1;
 
     int m_beatSubDivisions = 4;
     double m_quantizedBeatRange = 0;
     double m_recordBeatStart = 0;
     double m_beatStart = 0;
     double m_beatEnd = 0;
+    //the absolute record start beat the analyzed midi was last matched at
+    double m_matchedRecordBeatStart = 0;
+    double m_measureStart = 0;
+    double m_measureLength = 0;
+    double m_recordStartMeasure = 0;
     int m_lowestNote = 0;
     int m_highestNote = 0;
 
     double m_bpm = 120;
+    std::shared_ptr<const TempoMap> m_tempoMap;
     //threshold for when a midi note is considered "on time" and not late or early
     double m_msTimeThreshold = 20;
 
+    bool m_oneToOneAlignment = false;
+    double m_msAlignmentWindow = 100;
+    juce::Array<int> m_missedQuantizedIndices;
+
+    TimingStatistics m_timingStatistics;
+    bool m_timingStatisticsDirty = true;
+    LiveScore m_liveScore;
+    bool m_showLiveScore = false;
+
+    std::shared_ptr<const PeakPyramid> m_waveform;
+    float m_waveformThresholdGain = 1;
+
     float noteDisplayWidth = 2;
     float analyzedNoteDisplayWidth = 4;
+    int summaryStripHeight = 18;
+    int waveformLaneHeight = 80;
     const juce::Colour quantizedColor{ 0xffbbbbbb };
     const juce::Colour onTimeColor{ 0xff44dd44 };
     const juce::Colour lateColor{ 0xffdd4444 };
     const juce::Colour earlyColor{ 0xffd49306 };
+    const juce::Colour missedColor{ 0xff4488ee };
+    const juce::Colour extraColor{ 0xffaa44dd };
+    const juce::Colour waveformColor{ 0xff78909c };
+    const juce::Colour waveformThresholdColor{ 0xffeeee44 };
 
     //==============================================================================
 };
\ No newline at end of file
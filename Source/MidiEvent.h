@@ -41,7 +41,7 @@ struct MidiEvent
         return beatPosition * quarterNoteTicks;
     }
 
-    double getTickStart(int newQuarterNoteTicks) { return tickStart / quarterNoteTicks * newQuarterNoteTicks; }
+    double getTickStart(int newQuarterNoteTicks) const { return tickStart / quarterNoteTicks * newQuarterNoteTicks; }
 
     juce::String debugMidiEvent()
     {
@@ -0,0 +1,521 @@
+#include "MidiMatcher.h"
+#include <algorithm>
+#include <numeric>
+
+//==============================================================================
+
+void MidiMatcher::setReference(const vArray<MidiEvent>& reference)
+{
+    clearReference();
+
+    std::vector<int> order(reference.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return normalizeTick(reference.getReference(a)) < normalizeTick(reference.getReference(b));
+    });
+
+    m_allNotes.ticks.reserve(order.size());
+    m_allNotes.indices.reserve(order.size());
+    for (int index : order)
+    {
+        m_allNotes.ticks.push_back(normalizeTick(reference.getReference(index)));
+        m_allNotes.indices.push_back(index);
+    }
+    m_allNotes.updateRunStarts();
+
+    m_referenceNotes.reserve(reference.size());
+    for (const MidiEvent& midi : reference)
+        m_referenceNotes.push_back(juce::jlimit(0, 127, midi.note));
+
+    updatePitchBuckets();
+}
+
+void MidiMatcher::clearReference()
+{
+    m_allNotes = ReferenceBucket();
+    m_pitchBuckets.clear();
+    m_referenceNotes.clear();
+    m_hits.clear();
+}
+
+void MidiMatcher::setPitchGroups(const juce::Array<juce::Array<int>>& pitchGroups)
+{
+    for (int note = 0; note < (int)m_pitchGroups.size(); note++)
+        m_pitchGroups[note] = note;
+
+    for (const juce::Array<int>& group : pitchGroups)
+    {
+        //keyed on its first note that is a midi note, notes out of range are ignored
+        int groupKey = -1;
+        for (int note : group)
+        {
+            if (note < 0 || note >= (int)m_pitchGroups.size())
+                continue;
+            if (groupKey < 0)
+                groupKey = note;
+            m_pitchGroups[note] = groupKey;
+        }
+    }
+
+    updatePitchBuckets();
+}
+
+juce::Array<juce::Array<int>> MidiMatcher::parsePitchGroups(const juce::String& text)
+{
+    juce::Array<juce::Array<int>> pitchGroups;
+    for (const juce::String& groupText : juce::StringArray::fromTokens(text, ",;", ""))
+    {
+        juce::Array<int> group;
+        for (const juce::String& noteText : juce::StringArray::fromTokens(groupText, false))
+        {
+            //a note out of range would match nothing
+            if (noteText.containsOnly("0123456789") && noteText.length() <= 3 && noteText.getIntValue() <= 127)
+                group.add(noteText.getIntValue());
+        }
+
+        if (group.size() > 1)
+            pitchGroups.add(group);
+    }
+    return pitchGroups;
+}
+
+void MidiMatcher::updatePitchBuckets()
+{
+    //the kept hits were matched against the old buckets
+    m_hits.clear();
+    m_pitchBuckets.clear();
+
+    //m_allNotes is already sorted so every bucket is too
+    for (size_t i = 0; i < m_allNotes.indices.size(); i++)
+    {
+        int index = m_allNotes.indices[i];
+        ReferenceBucket& bucket = m_pitchBuckets[m_pitchGroups[m_referenceNotes[index]]];
+        bucket.ticks.push_back(m_allNotes.ticks[i]);
+        bucket.indices.push_back(index);
+    }
+
+    int cursorIndex = 1;
+    for (auto& [groupKey, bucket] : m_pitchBuckets)
+    {
+        bucket.updateRunStarts();
+        bucket.cursorIndex = cursorIndex++;
+    }
+}
+
+int MidiMatcher::getBucketKey(const MidiEvent& midi) const
+{
+    if (midi.useQuantizedNote) //the hit doesn't have a pitch
+        return allNotesBucket;
+
+    if (midi.note < 0 || midi.note >= (int)m_pitchGroups.size())
+        return noBucket;
+
+    return m_pitchGroups[midi.note];
+}
+
+const MidiMatcher::ReferenceBucket* MidiMatcher::getBucket(int bucketKey) const
+{
+    if (bucketKey == allNotesBucket)
+        return &m_allNotes;
+
+    auto bucket = m_pitchBuckets.find(bucketKey);
+    return bucket != m_pitchBuckets.end() ? &bucket->second : nullptr;
+}
+
+void MidiMatcher::matchClosest(vArray<MidiEvent>& analyzedMidi, double recordBeatStart) const
+{
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+    for (MidiEvent& midi : analyzedMidi)
+        midi.closestQuantizedIndex = findClosest(midi, normalizeTick(midi) + recordTickStart);
+}
+
+int MidiMatcher::findClosest(const MidiEvent& midi, double tick) const
+{
+    const ReferenceBucket* bucket = getBucket(midi);
+    return bucket != nullptr ? bucket->findClosest(tick) : -1;
+}
+
+void MidiMatcher::prepareCursor(Cursor& cursor) const
+{
+    cursor.positions.assign(m_pitchBuckets.size() + 1, 0);
+}
+
+int MidiMatcher::findClosest(const MidiEvent& midi, double tick, Cursor& cursor) const
+{
+    const ReferenceBucket* bucket = getBucket(midi);
+    if (bucket == nullptr)
+        return -1;
+    if (bucket->cursorIndex >= (int)cursor.positions.size())
+        return bucket->findClosest(tick);
+
+    int& after = cursor.positions[(size_t)bucket->cursorIndex];
+    after = bucket->seek(tick, juce::jlimit(0, (int)bucket->ticks.size(), after));
+    return bucket->closestAt(tick, after);
+}
+
+void MidiMatcher::setAnalyzed(vArray<MidiEvent>& analyzedMidi, double recordBeatStart)
+{
+    m_recordBeatStart = recordBeatStart;
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+
+    m_hits.resize(analyzedMidi.size());
+    for (int i = 0; i < analyzedMidi.size(); i++)
+        matchHit(analyzedMidi.getReference(i), m_hits[i], recordTickStart);
+}
+
+void MidiMatcher::addAnalyzed(vArray<MidiEvent>& analyzedMidi, double recordBeatStart)
+{
+    if ((int)m_hits.size() > analyzedMidi.size() || recordBeatStart != m_recordBeatStart)
+    {
+        setAnalyzed(analyzedMidi, recordBeatStart);
+        return;
+    }
+
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+    size_t numKept = m_hits.size();
+    m_hits.resize(analyzedMidi.size());
+    for (int i = (int)numKept; i < analyzedMidi.size(); i++)
+        matchHit(analyzedMidi.getReference(i), m_hits[i], recordTickStart);
+}
+
+void MidiMatcher::matchHit(MidiEvent& midi, MatchedHit& hit, double recordTickStart) const
+{
+    hit.bucketKey = getBucketKey(midi);
+    hit.tick = normalizeTick(midi);
+    const ReferenceBucket* bucket = getBucket(hit.bucketKey);
+    if (bucket == nullptr)
+    {
+        hit.bucketKey = noBucket;
+        midi.closestQuantizedIndex = -1;
+        return;
+    }
+
+    hit.after = bucket->lowerBound(hit.tick + recordTickStart);
+    midi.closestQuantizedIndex = bucket->closestAt(hit.tick + recordTickStart, hit.after);
+}
+
+void MidiMatcher::shiftRecordStart(vArray<MidiEvent>& analyzedMidi, double recordBeatStart)
+{
+    if ((int)m_hits.size() != analyzedMidi.size() || m_hits.empty())
+    {
+        setAnalyzed(analyzedMidi, recordBeatStart);
+        return;
+    }
+
+    m_recordBeatStart = recordBeatStart;
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+    //hits of the same bucket usually follow each other, so the bucket is only looked up when the key changes
+    int bucketKey = noBucket;
+    const ReferenceBucket* bucket = nullptr;
+    for (int i = 0; i < analyzedMidi.size(); i++)
+    {
+        MatchedHit& hit = m_hits[i];
+        if (hit.bucketKey == noBucket)
+            continue;
+        if (hit.bucketKey != bucketKey)
+        {
+            bucketKey = hit.bucketKey;
+            bucket = getBucket(bucketKey);
+        }
+
+        hit.after = bucket->seek(hit.tick + recordTickStart, hit.after);
+        analyzedMidi.getReference(i).closestQuantizedIndex = bucket->closestAt(hit.tick + recordTickStart, hit.after);
+    }
+}
+
+void MidiMatcher::ReferenceBucket::updateRunStarts()
+{
+    runStarts.resize(ticks.size());
+    for (size_t i = 0; i < ticks.size(); i++)
+        runStarts[i] = (i > 0 && ticks[i] == ticks[i - 1]) ? runStarts[i - 1] : (int)i;
+}
+
+int MidiMatcher::ReferenceBucket::lowerBound(double tick) const
+{
+    return (int)(std::lower_bound(ticks.begin(), ticks.end(), tick) - ticks.begin());
+}
+
+int MidiMatcher::ReferenceBucket::seek(double tick, int after) const
+{
+    //a shift usually only passes a few notes, a long one is quicker to search
+    const int maxSteps = 16;
+    for (int step = 0; step < maxSteps; step++)
+    {
+        if (after < (int)ticks.size() && ticks[after] < tick)
+            after++;
+        else if (after > 0 && ticks[after - 1] >= tick)
+            after--;
+        else
+            return after;
+    }
+    return lowerBound(tick);
+}
+
+int MidiMatcher::ReferenceBucket::closestAt(double tick, int after) const
+{
+    if (ticks.empty())
+        return -1;
+    if (after == 0)
+        return indices.front();
+
+    //the first note of the run of equal ticks before the hit, so ties resolve like the nested scan did
+    int before = runStarts[after - 1];
+    int beforeIndex = indices[before];
+    if (after == (int)ticks.size())
+        return beforeIndex;
+
+    int afterIndex = indices[after];
+    double beforeDifference = tick - ticks[before];
+    double afterDifference = ticks[after] - tick;
+    if (beforeDifference == afterDifference)
+        return std::min(beforeIndex, afterIndex);
+    return beforeDifference < afterDifference ? beforeIndex : afterIndex;
+}
+
+MidiMatcher::Alignment MidiMatcher::alignOneToOne(vArray<MidiEvent>& analyzedMidi, double recordBeatStart, double toleranceTicks) const
+{
+    Alignment alignment;
+    double recordTickStart = recordBeatStart * g_defaultQuarterNoteTicks;
+
+    std::vector<int> order(analyzedMidi.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return normalizeTick(analyzedMidi.getReference(a)) < normalizeTick(analyzedMidi.getReference(b));
+    });
+    if (order.empty())
+        return alignment;
+
+    //only the part of the reference that the take covers can have missed notes
+    double firstTick = normalizeTick(analyzedMidi.getReference(order.front())) + recordTickStart - toleranceTicks;
+    double lastTick = normalizeTick(analyzedMidi.getReference(order.back())) + recordTickStart + toleranceTicks;
+
+    //every bucket is aligned on its own, hits keep their sorted order within a bucket
+    std::map<const ReferenceBucket*, std::vector<int>> bucketHits;
+    for (int index : order)
+    {
+        MidiEvent& midi = analyzedMidi.getReference(index);
+        const ReferenceBucket* bucket = getBucket(midi);
+        if (bucket == nullptr)
+        {
+            midi.closestQuantizedIndex = -1;
+            alignment.extraAnalyzedIndices.add(index);
+            continue;
+        }
+        bucketHits[bucket].push_back(index);
+    }
+
+    std::vector<bool> referenceMatched(m_referenceNotes.size(), false);
+    std::vector<double> hitTicks;
+    std::vector<int> hitMatches;
+    for (auto& [bucket, hits] : bucketHits)
+    {
+        hitTicks.clear();
+        for (int index : hits)
+            hitTicks.push_back(normalizeTick(analyzedMidi.getReference(index)) + recordTickStart);
+
+        int referenceStart = (int)(std::lower_bound(bucket->ticks.begin(), bucket->ticks.end(), firstTick) - bucket->ticks.begin());
+        int referenceEnd = (int)(std::upper_bound(bucket->ticks.begin(), bucket->ticks.end(), lastTick) - bucket->ticks.begin());
+        alignSorted(hitTicks, bucket->ticks.data() + referenceStart, referenceEnd - referenceStart, toleranceTicks, hitMatches);
+
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            MidiEvent& midi = analyzedMidi.getReference(hits[i]);
+            if (hitMatches[i] < 0)
+            {
+                midi.closestQuantizedIndex = -1;
+                alignment.extraAnalyzedIndices.add(hits[i]);
+                continue;
+            }
+            midi.closestQuantizedIndex = bucket->indices[referenceStart + hitMatches[i]];
+            referenceMatched[midi.closestQuantizedIndex] = true;
+            alignment.cost += std::abs(hitTicks[i] - bucket->ticks[referenceStart + hitMatches[i]]);
+            alignment.numMatched++;
+        }
+    }
+
+    //notes of a pitch that wasn't played at all are missed too
+    auto allStart = std::lower_bound(m_allNotes.ticks.begin(), m_allNotes.ticks.end(), firstTick) - m_allNotes.ticks.begin();
+    auto allEnd = std::upper_bound(m_allNotes.ticks.begin(), m_allNotes.ticks.end(), lastTick) - m_allNotes.ticks.begin();
+    for (auto i = allStart; i < allEnd; i++)
+    {
+        int index = m_allNotes.indices[i];
+        if (!referenceMatched[index])
+            alignment.missedQuantizedIndices.add(index);
+    }
+    alignment.cost += toleranceTicks * (alignment.missedQuantizedIndices.size() + alignment.extraAnalyzedIndices.size());
+
+    return alignment;
+}
+
+double MidiMatcher::alignSorted(const std::vector<double>& hitTicks, const double* referenceTicks, int numReference,
+                                double toleranceTicks, std::vector<int>& hitMatches)
+{
+    //cost(i, j) is the best alignment of the first i hits with the first j reference notes, a missed or extra note
+    //costs toleranceTicks and a match costs its distance. Row i only stores the reference notes within the
+    //tolerance of hit i (plus the one before them): left of that the row is the row above plus an extra hit,
+    //right of it the row only adds missed notes.
+    enum Move : char { extraHit, missedNote, match };
+    struct Row { int first = 0; int last = 0; size_t offset = 0; };
+
+    int numHits = (int)hitTicks.size();
+    double penalty = toleranceTicks;
+    std::vector<Row> rows(numHits + 1);
+    std::vector<double> costs{ 0 };
+    std::vector<Move> moves{ missedNote };
+
+    auto getCost = [&](int i, int j)
+    {
+        const Row& row = rows[i];
+        if (j > row.last)
+            return costs[row.offset + row.last - row.first] + (j - row.last) * penalty;
+        return costs[row.offset + j - row.first];
+    };
+
+    const double* referenceEnd = referenceTicks + numReference;
+    for (int i = 1; i <= numHits; i++)
+    {
+        double hitTick = hitTicks[i - 1];
+        //1-based window of reference notes that hit i can match
+        int windowStart = (int)(std::lower_bound(referenceTicks, referenceEnd, hitTick - toleranceTicks) - referenceTicks) + 1;
+        int windowEnd = (int)(std::upper_bound(referenceTicks, referenceEnd, hitTick + toleranceTicks) - referenceTicks);
+
+        Row& row = rows[i];
+        row.first = windowStart - 1;
+        row.last = std::max(windowEnd, row.first);
+        row.offset = costs.size();
+
+        costs.push_back(getCost(i - 1, row.first) + penalty);
+        moves.push_back(extraHit);
+        for (int j = row.first + 1; j <= row.last; j++)
+        {
+            double matchCost = getCost(i - 1, j - 1) + std::abs(hitTick - referenceTicks[j - 1]);
+            double extraCost = getCost(i - 1, j) + penalty;
+            double missedCost = costs.back() + penalty;
+
+            if (matchCost <= extraCost && matchCost <= missedCost)
+            {
+                costs.push_back(matchCost);
+                moves.push_back(match);
+            }
+            else if (extraCost <= missedCost)
+            {
+                costs.push_back(extraCost);
+                moves.push_back(extraHit);
+            }
+            else
+            {
+                costs.push_back(missedCost);
+                moves.push_back(missedNote);
+            }
+        }
+    }
+
+    hitMatches.assign(numHits, -1);
+    int i = numHits;
+    int j = numReference;
+    while (i > 0)
+    {
+        const Row& row = rows[i];
+        if (j > row.last)
+        {
+            j--; //missed note
+            continue;
+        }
+
+        Move move = moves[row.offset + j - row.first];
+        if (move == match)
+            hitMatches[--i] = --j;
+        else if (move == extraHit)
+            i--;
+        else
+            j--;
+    }
+
+    return getCost(numHits, numReference);
+}
+
+void MidiMatcher::matchClosestBruteForce(vArray<MidiEvent>& analyzedMidi, const vArray<MidiEvent>& quantizedMidi, double recordBeatStart)
+{
+    for (MidiEvent& midi : analyzedMidi)
+    {
+        if (quantizedMidi.isEmpty())
+        {
+            midi.closestQuantizedIndex = -1;
+            continue;
+        }
+
+        //relative to the record start
+        double tickStart = midi.tickStart + recordBeatStart * midi.quarterNoteTicks;
+
+        double lowestDifference = tickStart - quantizedMidi[0].getTickStart(midi.quarterNoteTicks);
+        int closestQuantizedIndex = 0;
+        for (int i = 1; i < quantizedMidi.size(); i++)
+        {
+            double quantizedTickStart = quantizedMidi[i].getTickStart(midi.quarterNoteTicks);
+            if (std::abs(tickStart - quantizedTickStart) < std::abs(lowestDifference))
+            {
+                lowestDifference = tickStart - quantizedTickStart;
+                closestQuantizedIndex = i;
+            }
+        }
+        midi.closestQuantizedIndex = closestQuantizedIndex;
+    }
+}
+
+BenchmarkResult MidiMatcher::benchmark(int numNotes)
+{
+    juce::Random random(numNotes);
+    int quarterNoteTicks = g_defaultQuarterNoteTicks;
+    int sixteenthTicks = quarterNoteTicks / 4;
+
+    vArray<MidiEvent> quantizedMidi;
+    vArray<MidiEvent> analyzedMidi;
+    double tick = 0;
+    for (int i = 0; i < numNotes; i++)
+    {
+        tick += sixteenthTicks * (random.nextInt(2) + 1);
+
+        MidiEvent quantized;
+        quantized.note = 36 + random.nextInt(12);
+        quantized.tickStart = tick;
+        quantized.tickEnd = tick;
+        quantizedMidi.add(quantized);
+
+        MidiEvent analyzed = quantized;
+        analyzed.useQuantizedNote = true; //the nested scan ignored pitch
+        analyzed.tickStart = tick + random.nextInt({ -sixteenthTicks, sixteenthTicks });
+        analyzedMidi.add(analyzed);
+    }
+    vArray<MidiEvent> bruteForceMidi = analyzedMidi;
+
+    juce::String output = "MidiMatcher::benchmark " + juce::String(numNotes) + " notes\n";
+
+    TimerBench timerBench;
+    MidiMatcher matcher;
+    matcher.setReference(quantizedMidi);
+    matcher.matchClosest(analyzedMidi, 0);
+    output += timerBench.StopAndGetTime("matchClosest (us)") + "\n";
+
+    vArray<MidiEvent> pitchedMidi = analyzedMidi;
+    for (MidiEvent& midi : pitchedMidi)
+        midi.useQuantizedNote = false;
+    timerBench.Start();
+    matcher.matchClosest(pitchedMidi, 0);
+    output += timerBench.StopAndGetTime("matchClosest by pitch (us)") + "\n";
+
+    timerBench.Start();
+    matchClosestBruteForce(bruteForceMidi, quantizedMidi, 0);
+    output += timerBench.StopAndGetTime("matchClosestBruteForce (us)") + "\n";
+
+    int mismatches = 0;
+    for (int i = 0; i < analyzedMidi.size(); i++)
+    {
+        if (analyzedMidi[i].closestQuantizedIndex != bruteForceMidi[i].closestQuantizedIndex)
+            mismatches++;
+    }
+    output += "mismatches: " + juce::String(mismatches) + "\n";
+
+    return { output, mismatches };
+}
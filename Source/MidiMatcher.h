@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Globals.h"
+#include "MidiEvent.h"
+#include <array>
+#include <map>
+#include <vector>
+
+//==============================================================================
+//matches analyzed midi hits to the quantized midi they were played against
+class MidiMatcher
+{
+public:
+    MidiMatcher() { setPitchGroups({}); }
+
+    struct Alignment
+    {
+        int numMatched = 0;
+        //reference notes that no analyzed hit was assigned to
+        juce::Array<int> missedQuantizedIndices;
+        //analyzed hits that were not assigned to a reference note
+        juce::Array<int> extraAnalyzedIndices;
+        //sum of the tick distance of every match plus toleranceTicks for every missed or extra note
+        double cost = 0;
+    };
+
+    //sorts the reference once, every tick is normalized to g_defaultQuarterNoteTicks
+    void setReference(const vArray<MidiEvent>& reference);
+    void clearReference();
+    int getReferenceSize() const { return (int)m_allNotes.ticks.size(); }
+
+    //notes in the same group are matched as if they were the same pitch, e.g. { 42, 44, 46 } for every hi-hat of a kit.
+    //A note can only be in one group, notes that aren't in a group are only matched to their own pitch
+    void setPitchGroups(const juce::Array<juce::Array<int>>& pitchGroups);
+    //parses groups written as "42 44 46, 38 40", numbers above 127 are dropped
+    static juce::Array<juce::Array<int>> parsePitchGroups(const juce::String& text);
+
+    //sets closestQuantizedIndex of every analyzed midi event, recordBeatStart is the absolute beat of the record start.
+    //Hits that use the quantized note (audio hits) can match any pitch, every other hit only matches its own pitch group
+    void matchClosest(vArray<MidiEvent>& analyzedMidi, double recordBeatStart) const;
+    //returns the index into the reference of the closest quantized note that the hit can match or -1 if there is none
+    int findClosest(const MidiEvent& midi, double tick) const;
+
+    //the position of the last hit in every pitch bucket, so hits that arrive in time order only walk a note or two
+    struct Cursor
+    {
+        std::vector<int> positions;
+    };
+    //sizes the cursor for the buckets of the reference and moves it to the start, the only allocation of a cursor
+    void prepareCursor(Cursor& cursor) const;
+    //findClosest that walks from the previous hit of the same bucket and falls back to a search after a jump,
+    //never allocates. The cursor has to be prepared after the reference or pitch groups were set
+    int findClosest(const MidiEvent& midi, double tick, Cursor& cursor) const;
+
+    //matchClosest that keeps the hits so a new record start can be applied incrementally with shiftRecordStart
+    void setAnalyzed(vArray<MidiEvent>& analyzedMidi, double recordBeatStart);
+    //moves the kept hits to a new record start by walking each one from its current closest note, so a small shift
+    //costs O(N) instead of a new search. Falls back to setAnalyzed if the hits aren't the ones that were kept
+    void shiftRecordStart(vArray<MidiEvent>& analyzedMidi, double recordBeatStart);
+    //matches only the hits that were added to the end of the kept hits, e.g. the live hits of every timer callback.
+    //Falls back to setAnalyzed if the record start changed or the kept hits aren't a start of analyzedMidi
+    void addAnalyzed(vArray<MidiEvent>& analyzedMidi, double recordBeatStart);
+    bool hasAnalyzed() const { return !m_hits.empty(); }
+    int getNumAnalyzed() const { return (int)m_hits.size(); }
+    double getRecordBeatStart() const { return m_recordBeatStart; }
+
+    //best one-to-one assignment of analyzed hits to reference notes that are at most toleranceTicks apart,
+    //hits without a match get a closestQuantizedIndex of -1. Missed notes are only reported between the first
+    //and last analyzed hit so a take of part of the song doesn't miss the rest of it
+    Alignment alignOneToOne(vArray<MidiEvent>& analyzedMidi, double recordBeatStart, double toleranceTicks) const;
+
+    //the nested scan that used to live in MidiDisplay::updateAnalyzedMidi, O(N*M)
+    static void matchClosestBruteForce(vArray<MidiEvent>& analyzedMidi, const vArray<MidiEvent>& quantizedMidi, double recordBeatStart);
+
+    //times matchClosest against matchClosestBruteForce on random midi, every hit where they disagree fails
+    static BenchmarkResult benchmark(int numNotes);
+
+    inline static double normalizeTick(double tick, int quarterNoteTicks) { return tick * (g_defaultQuarterNoteTicks / quarterNoteTicks); }
+    inline static double normalizeTick(const MidiEvent& midi) { return normalizeTick(midi.tickStart, midi.quarterNoteTicks); }
+
+private:
+    struct ReferenceBucket
+    {
+        int findClosest(double tick) const { return closestAt(tick, lowerBound(tick)); }
+        //the reference index of the closest note, after is the position of the first note at or after tick
+        int closestAt(double tick, int after) const;
+        int lowerBound(double tick) const;
+        //lowerBound found by walking from the position of a previous tick
+        int seek(double tick, int after) const;
+        void updateRunStarts();
+
+        //sorted by tick, equal ticks keep the order of the reference
+        std::vector<double> ticks;
+        std::vector<int> indices;
+        //position of the first note with the same tick
+        std::vector<int> runStarts;
+        //position of the bucket in a Cursor
+        int cursorIndex = 0;
+    };
+
+    //keys of the buckets that aren't a pitch group
+    static constexpr int noBucket = -1;
+    static constexpr int allNotesBucket = 128;
+
+    struct MatchedHit
+    {
+        //the key of the bucket instead of a pointer, so a copied matcher only uses its own buckets
+        int bucketKey = noBucket;
+        //normalized tick without the record start
+        double tick = 0;
+        int after = 0;
+    };
+
+    //the key of the bucket a hit is matched against, getBucket returns nullptr if the reference doesn't have its pitch
+    int getBucketKey(const MidiEvent& midi) const;
+    const ReferenceBucket* getBucket(int bucketKey) const;
+    const ReferenceBucket* getBucket(const MidiEvent& midi) const { return getBucket(getBucketKey(midi)); }
+    //keeps the hit and sets the closestQuantizedIndex of the midi
+    void matchHit(MidiEvent& midi, MatchedHit& hit, double recordTickStart) const;
+    void updatePitchBuckets();
+
+    //banded dp over hits and reference notes that are both sorted by tick, hitMatches gets the reference position
+    //of every hit or -1, only the cells within toleranceTicks of each hit are stored so the cost stays close to linear
+    static double alignSorted(const std::vector<double>& hitTicks, const double* referenceTicks, int numReference,
+                              double toleranceTicks, std::vector<int>& hitMatches);
+
+    ReferenceBucket m_allNotes;
+    //keyed by the pitch group of the notes
+    std::map<int, ReferenceBucket> m_pitchBuckets;
+    std::array<int, 128> m_pitchGroups;
+    //the note of every reference index
+    std::vector<int> m_referenceNotes;
+
+    //kept by setAnalyzed, in the order of the analyzed midi
+    std::vector<MatchedHit> m_hits;
+    double m_recordBeatStart = 0;
+
+private:
+    JUCE_LEAK_DETECTOR(MidiMatcher)
+};
@@ -0,0 +1,162 @@
+#include "PeakPyramid.h"
+
+//==============================================================================
+
+void PeakPyramid::reset(double sampleRate)
+{
+    m_levels.assign(1, {});
+    m_sampleRate = sampleRate;
+    m_lengthInSamples = 0;
+    m_numPending = 0;
+}
+
+void PeakPyramid::addSamples(const float* const* channels, int numChannels, int numSamples)
+{
+    if (m_levels.empty())
+        m_levels.resize(1);
+
+    for (int start = 0; start < numSamples;)
+    {
+        int length = juce::jmin(samplesPerPeak - m_numPending, numSamples - start);
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax(channels[channel] + start, length);
+            bool first = m_numPending == 0 && channel == 0;
+            m_pendingMin = first ? range.getStart() : juce::jmin(m_pendingMin, range.getStart());
+            m_pendingMax = first ? range.getEnd() : juce::jmax(m_pendingMax, range.getEnd());
+        }
+        m_numPending += length;
+        start += length;
+
+        if (m_numPending == samplesPerPeak)
+        {
+            m_levels[0].push_back({ m_pendingMin, m_pendingMax });
+            m_lengthInSamples += samplesPerPeak;
+            m_numPending = 0;
+        }
+    }
+}
+
+void PeakPyramid::addPeak(juce::Range<float> peak, int numSamples)
+{
+    jassert(m_numPending == 0);
+    if (m_levels.empty())
+        m_levels.resize(1);
+
+    m_levels[0].push_back(peak);
+    m_lengthInSamples += numSamples;
+}
+
+void PeakPyramid::finish()
+{
+    if (m_levels.empty())
+        return;
+
+    if (m_numPending > 0)
+    {
+        m_levels[0].push_back({ m_pendingMin, m_pendingMax });
+        m_lengthInSamples += m_numPending;
+        m_numPending = 0;
+    }
+
+    //every peak is the union of two peaks of the level below, until one peak covers the take
+    m_levels.resize(1);
+    while (m_levels.back().size() > 1)
+    {
+        const std::vector<juce::Range<float>>& finer = m_levels.back();
+        std::vector<juce::Range<float>> coarser((finer.size() + 1) / 2);
+        for (size_t i = 0; i < coarser.size(); i++)
+        {
+            coarser[i] = finer[i * 2];
+            if (i * 2 + 1 < finer.size())
+                coarser[i] = coarser[i].getUnionWith(finer[i * 2 + 1]);
+        }
+        m_levels.push_back(std::move(coarser));
+    }
+}
+
+int PeakPyramid::getLevel(double samplesPerPixel) const
+{
+    int level = 0;
+    while (level + 1 < getNumLevels() && getSamplesPerPeak(level + 1) <= samplesPerPixel)
+        level++;
+    return level;
+}
+
+juce::Range<float> PeakPyramid::getRange(int level, juce::int64 startSample, juce::int64 endSample) const
+{
+    if (isEmpty() || level < 0 || level >= getNumLevels())
+        return {};
+
+    const std::vector<juce::Range<float>>& peaks = m_levels[(size_t)level];
+    juce::int64 peakSize = getSamplesPerPeak(level);
+    juce::int64 first = juce::jmax<juce::int64>(0, startSample / peakSize);
+    juce::int64 last = juce::jmin<juce::int64>((juce::int64)peaks.size(), (endSample + peakSize - 1) / peakSize);
+    if (startSample < 0 || first >= last)
+        return {};
+
+    juce::Range<float> range = peaks[(size_t)first];
+    for (juce::int64 i = first + 1; i < last; i++)
+        range = range.getUnionWith(peaks[(size_t)i]);
+    return range;
+}
+
+//==============================================================================
+
+BenchmarkResult PeakPyramid::benchmark(int numSeconds)
+{
+    double sampleRate = 48000;
+    int numSamples = (int)(numSeconds * sampleRate);
+    juce::Random random(numSeconds);
+
+    //decaying hits over quiet noise
+    juce::HeapBlock<float> samples(numSamples);
+    BenchmarkHits hits;
+    hits.sampleRate = sampleRate;
+    hits.generate(samples, numSamples, random);
+
+    juce::String output = "PeakPyramid::benchmark " + juce::String(numSeconds) + " s\n";
+    TimerBench timerBench;
+    PeakPyramid peakPyramid;
+    peakPyramid.reset(sampleRate);
+    for (int start = 0; start < numSamples; start += 1 << 16)
+    {
+        const float* channels[] = { samples + start };
+        peakPyramid.addSamples(channels, 1, juce::jmin(1 << 16, numSamples - start));
+    }
+    peakPyramid.finish();
+    output += timerBench.StopAndGetTime("build (us)") + ", levels: " + juce::String(peakPyramid.getNumLevels()) + "\n";
+
+    //a 1000 pixel wide display zoomed from a tenth of the take to all of it
+    const int width = 1000;
+    int notCovered = 0;
+    for (double fraction : { 0.1, 0.5, 1.0 })
+    {
+        double samplesPerPixel = numSamples * fraction / width;
+        int level = peakPyramid.getLevel(samplesPerPixel);
+
+        timerBench.Start();
+        juce::Array<juce::Range<float>> pyramidRanges;
+        for (int x = 0; x < width; x++)
+            pyramidRanges.add(peakPyramid.getRange(level, (juce::int64)(x * samplesPerPixel), (juce::int64)((x + 1) * samplesPerPixel)));
+        output += timerBench.StopAndGetTime("getRange at " + juce::String(fraction) + " of the take, level " + juce::String(level) + " (us)") + "\n";
+
+        timerBench.Start();
+        juce::Array<juce::Range<float>> sampleRanges;
+        for (int x = 0; x < width; x++)
+        {
+            int start = (int)(x * samplesPerPixel);
+            int end = juce::jmax(start + 1, (int)((x + 1) * samplesPerPixel));
+            sampleRanges.add(juce::FloatVectorOperations::findMinAndMax(samples + start, end - start));
+        }
+        output += timerBench.StopAndGetTime("findMinAndMax of the samples (us)") + "\n";
+
+        for (int x = 0; x < width; x++)
+        {
+            if (pyramidRanges[x].getStart() > sampleRanges[x].getStart() || pyramidRanges[x].getEnd() < sampleRanges[x].getEnd())
+                notCovered++;
+        }
+    }
+    output += "pixels whose samples are not covered: " + juce::String(notCovered) + "\n";
+    return { output, notCovered };
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Globals.h"
+#include <vector>
+
+//==============================================================================
+//min and max of an audio take at power of two resolutions, level 0 has a peak for every samplesPerPeak samples and
+//every level above has half as many peaks. Built once while the take is read so drawing it at any zoom only
+//looks at about one peak per pixel
+class PeakPyramid
+{
+public:
+    PeakPyramid() {}
+
+    //starts a new pyramid for audio at sampleRate
+    void reset(double sampleRate);
+    //adds the lowest and highest sample across the channels, blocks have to be passed in order
+    void addSamples(const float* const* channels, int numChannels, int numSamples);
+    //adds the peak of the next samplesPerPeak samples, or fewer for the last peak. Only between whole peaks of addSamples
+    void addPeak(juce::Range<float> peak, int numSamples = samplesPerPeak);
+    //adds the last partial peak and builds the coarser levels, call after the last samples
+    void finish();
+
+    bool isEmpty() const { return m_levels.empty() || m_levels[0].empty(); }
+    double getSampleRate() const { return m_sampleRate; }
+    juce::int64 getLengthInSamples() const { return m_lengthInSamples; }
+    int getNumLevels() const { return (int)m_levels.size(); }
+    static juce::int64 getSamplesPerPeak(int level) { return (juce::int64)samplesPerPeak << level; }
+
+    //the coarsest level with at most samplesPerPixel samples in a peak, a pixel is drawn from one or two of its peaks
+    int getLevel(double samplesPerPixel) const;
+    //the range of the peaks of the level that overlap startSample to endSample, nothing outside of the take
+    juce::Range<float> getRange(int level, juce::int64 startSample, juce::int64 endSample) const;
+
+    inline static const int samplesPerPeak = 256;
+
+    //times getRange for a screen of pixels at every zoom against the min and max of the samples, every pixel
+    //whose range doesn't cover its samples fails
+    static BenchmarkResult benchmark(int numSeconds);
+
+private:
+    std::vector<std::vector<juce::Range<float>>> m_levels;
+    double m_sampleRate = 0;
+    juce::int64 m_lengthInSamples = 0;
+
+    //the peak of level 0 that addSamples is filling
+    float m_pendingMin = 0;
+    float m_pendingMax = 0;
+    int m_numPending = 0;
+
+private:
+    JUCE_LEAK_DETECTOR(PeakPyramid)
+};
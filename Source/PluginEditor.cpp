@@ -13,9 +13,14 @@
 
 //==============================================================================
 TimeAnalyzerAudioProcessorEditor::TimeAnalyzerAudioProcessorEditor(TimeAnalyzerAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p), m_msDetectNewMidiFrequency(1000)
+    : AudioProcessorEditor(&p), audioProcessor(p),
+      m_directoryIndex([this](const juce::File& take, DirectoryIndex::Format format)
+                       { return format == DirectoryIndex::Format::midi ? canReadMidiFile(take) : canReadAudioFile(take); }),
+      m_msDetectNewMidiFrequency(1000), m_analysisWorker(p.audioDecoder), m_batchAnalyzer(p.audioDecoder)
 {
     initializeUI();
+    m_transportTimer.callback = [this]() { updateTransport(); };
+    m_transportTimer.startTimer(50);
 
     audioProcessor.stateLoadedCallback = [this]() { loadStateInfo(); };
     loadStateInfo();
@@ -23,6 +28,11 @@ TimeAnalyzerAudioProcessorEditor::TimeAnalyzerAudioProcessorEditor(TimeAnalyzerA
 
 TimeAnalyzerAudioProcessorEditor::~TimeAnalyzerAudioProcessorEditor()
 {
+    m_directoryWatcher.stop();
+    m_analysisWorker.cancel();
+    m_batchAnalyzer.cancel();
+    //the live mode keeps scoring and sending feedback, the hits that aren't popped are dropped by the queue
+    audioProcessor.stateLoadedCallback = nullptr;
 }
 
 bool TimeAnalyzerAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
@@ -38,17 +48,65 @@ bool TimeAnalyzerAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
     return false;
 }
 
-void TimeAnalyzerAudioProcessorEditor::timerCallback()
+void TimeAnalyzerAudioProcessorEditor::updateDirectoryWatcher()
 {
-    if (!m_quantizedMidiFile.exists() && quantizedMidi.isEmpty())
+    juce::File midiDirectory(midiDirectory_Editor.getText().unquoted());
+    if (!detectNewMidi_Toggle.getToggleState() || !midiDirectory.isDirectory())
+    {
+        m_directoryWatcher.stop();
+        m_pendingNewFile = juce::File();
+        return;
+    }
+
+    //the folder is applied when it's entered or loses focus, which doesn't always change it
+    bool recursive = includeSubfolders_Toggle.getToggleState();
+    if (m_directoryWatcher.isWatching() && m_directoryWatcher.getDirectory() == midiDirectory && m_directoryWatcher.isRecursive() == recursive
+        && (m_directoryWatcher.isEventDriven() || m_directoryWatcher.getPollInterval() == m_msDetectNewMidiFrequency))
         return;
 
-    if (audioProcessor.getPlayHead() != nullptr
-        && audioProcessor.getPlayHead()->getPosition()->getIsRecording())
+    //the watcher scans the folder on its thread once it watches it, until then the index keeps what it has
+    m_directoryIndex.setDirectory(midiDirectory, recursive, false);
+    m_directoryScanPending = true;
+
+    juce::Component::SafePointer<TimeAnalyzerAudioProcessorEditor> safeThis(this);
+    m_directoryWatcher.start(midiDirectory, [safeThis, recursive](const juce::File& file, DirectoryWatcher::Change change)
     {
-        //detectNewMidiLog.setText("recording");
-        return; //the host might be recording the newest midi file
-    }
+        if (change == DirectoryWatcher::Change::rescanNeeded)
+        {
+            auto scan = std::make_shared<DirectoryIndex::Scan>(DirectoryIndex::scanDirectory(file, recursive));
+            juce::MessageManager::callAsync([safeThis, scan]()
+            {
+                if (safeThis != nullptr)
+                    safeThis->directoryScanned(*scan);
+            });
+            return;
+        }
+
+        //a take is only complete once it's closed, a removed take only leaves the index
+        if (change != DirectoryWatcher::Change::closedAfterWrite && change != DirectoryWatcher::Change::removed)
+            return;
+        juce::MessageManager::callAsync([safeThis, file, change]()
+        {
+            if (safeThis == nullptr)
+                return;
+            if (change == DirectoryWatcher::Change::removed)
+                safeThis->m_directoryIndex.updateFile(file);
+            else
+                safeThis->newFileWritten(file);
+        });
+    }, m_msDetectNewMidiFrequency, recursive);
+    debugLog("updateDirectoryWatcher::isEventDriven: " + juce::String((int)m_directoryWatcher.isEventDriven()));
+}
+
+void TimeAnalyzerAudioProcessorEditor::newFileWritten(juce::File writtenFile)
+{
+    m_directoryIndex.updateFile(writtenFile);
+    if (!detectNewMidi_Toggle.getToggleState() || writtenFile == m_quantizedMidiFile)
+        return;
+
+    bool midiFile = !analyzeAudioFiles_Toggle.getToggleState();
+    if (!(midiFile ? AnalysisCore::isMidiFile(writtenFile) : AnalysisCore::isAudioFile(writtenFile)))
+        return;
 
     if (quantizedMidi.isEmpty())
     {
@@ -56,9 +114,38 @@ void TimeAnalyzerAudioProcessorEditor::timerCallback()
         return;
     }
 
-    juce::File newFile = getNewFile(!analyzeAudioFiles_Toggle.getToggleState());
-    if (newFile.exists() && (newFile != newestFile || newFile.getSize() != newestFileSize) && newFile != m_quantizedMidiFile)
-        analyzeFile(newFile);
+    updateTransport();
+    if (m_transport.isRecording)
+    {
+        m_pendingNewFile = writtenFile; //the host might write the take again until it stops recording
+        return;
+    }
+    m_pendingNewFile = juce::File();
+
+    if (m_directoryIndex.canRead(writtenFile))
+        analyzeFile(writtenFile);
+}
+
+void TimeAnalyzerAudioProcessorEditor::directoryScanned(const DirectoryIndex::Scan& scan)
+{
+    //from a watcher of a folder that was replaced since
+    if (scan.directory != m_directoryIndex.getDirectory() || scan.recursive != m_directoryIndex.isRecursive())
+        return;
+
+    TimerBench timerBench("Apply Directory Scan Time");
+    m_directoryIndex.applyScan(scan);
+    debugLog(timerBench.StopAndGetTime());
+    //the first scan of a watch only has the takes from before it
+    if (m_directoryScanPending)
+    {
+        m_directoryScanPending = false;
+        return;
+    }
+
+    juce::File newest = getNewFile(!analyzeAudioFiles_Toggle.getToggleState());
+    if (newest != juce::File() && (newest != newestFile || newest.getSize() != newestFileSize))
+        newFileWritten(newest);
+    debugLog("directoryScanned::newest: " + newest.getFileName());
 }
 
 void TimeAnalyzerAudioProcessorEditor::setQuantizedMidiFile(juce::File quantizedMidiFile)
@@ -70,33 +157,56 @@ void TimeAnalyzerAudioProcessorEditor::setQuantizedMidiFile(juce::File quantized
     if (!getMidiFile(quantizedMidiFile, quantizedMidiFileObject))
         return;
     readMidiFile(quantizedMidiFileObject, quantizedMidi);
+    //a single tempo and meter keeps using the host or edited tempo
+    auto tempoMap = std::make_shared<TempoMap>(TempoMap::fromMidiFile(quantizedMidiFileObject, getCurrentBpm()));
+    m_tempoMap = tempoMap->hasChanges() ? tempoMap : nullptr;
 
     m_quantizedMidiFile = quantizedMidiFile;
     audioProcessor.stateInfo.setProperty(NAME_OF(m_quantizedMidiFile), m_quantizedMidiFile.getFullPathName(), nullptr);
 
+    m_midiDisplay.setTempoMap(getTempoMap(), false);
     m_midiDisplay.setQuantizedMidi(quantizedMidi);
+    m_liveReferenceDirty = true;
     debugPlugin("setQuantizedMidiFile");
 }
 
 void TimeAnalyzerAudioProcessorEditor::analyzeFile()
 {
+    if (liveInput_Toggle.getToggleState())
+        return; //the display shows the live hits
+
     if (quantizedMidi.isEmpty())
     {
         detectNewMidiLog.setText("Please Set a Quantized Midi File");
         return;
     }
 
+    juce::File take = analyzeAudioFiles_Toggle.getToggleState() ? audioFileToAnalyze : midiFileToAnalyze;
+    if (!take.existsAsFile())
+        return;
+
     setPlayHeadInfo();
 
-    vArray<MidiEvent> midiEventsToAnalyze;
-    if (analyzeAudioFiles_Toggle.getToggleState())
-        readAudioFile(audioFileToAnalyze, midiEventsToAnalyze);
-    else
-        readMidiFile(midiFileToAnalyze, midiEventsToAnalyze); 
-    m_midiDisplay.setAnalyzedMidi(midiEventsToAnalyze);
+    AnalysisWorker::Request request;
+    request.take = take;
+    request.quantizedMidi = quantizedMidi;
+    request.pitchGroups = MidiMatcher::parsePitchGroups(pitchGroups_Editor.getText());
+    request.settings = getAnalysisSettings();
+    request.matchVersion = m_midiDisplay.getMatchVersion();
+    request.useResultFile = saveResults_Toggle.getToggleState();
 
-    detectNewMidiLog.setText(jString() + "newestFile: " + newestFile.getFileName());
-    debugPlugin("analyzeFile");
+    juce::Component::SafePointer<TimeAnalyzerAudioProcessorEditor> editor(this);
+    juce::uint32 generation = m_analysisWorker.analyze(std::move(request), [editor](std::shared_ptr<const AnalyzedTake> analyzedTake)
+    {
+        juce::MessageManager::callAsync([editor, analyzedTake]()
+        {
+            //a newer request replaced it while it was on its way
+            if (editor != nullptr && !editor->m_analysisWorker.isStale(analyzedTake->generation))
+                editor->takeAnalyzed(*analyzedTake);
+        });
+    });
+    detectNewMidiLog.setText("Analyzing " + take.getFileName() + "...");
+    debugLog("analyzeFile::generation: " + juce::String(generation));
 }
 
 void TimeAnalyzerAudioProcessorEditor::analyzeFile(juce::File fileToAnalyze)
@@ -105,67 +215,147 @@ void TimeAnalyzerAudioProcessorEditor::analyzeFile(juce::File fileToAnalyze)
         return;
 
     if (analyzeAudioFiles_Toggle.getToggleState())
-    {
         audioFileToAnalyze = fileToAnalyze;
-    }
-    else if (!getMidiFile(fileToAnalyze, midiFileToAnalyze))
-    {
-        detectNewMidiLog.setText("can't read midi file");
-        return;
-    }
+    else
+        midiFileToAnalyze = fileToAnalyze;
     newestFile = fileToAnalyze;
     newestFileSize = newestFile.getSize();
     analyzeFile();
 }
 
-juce::File TimeAnalyzerAudioProcessorEditor::getNewFile(bool midiFile)
+void TimeAnalyzerAudioProcessorEditor::takeAnalyzed(const AnalyzedTake& analyzedTake)
 {
-    juce::File newMidiDirectory(midiDirectory_Editor.getText().unquoted());
-    if (!newMidiDirectory.exists() || !newMidiDirectory.isDirectory())
-        return juce::File();
+    if (liveInput_Toggle.getToggleState())
+        return;
 
-    jString fileExtension = midiFile ? ".mid" : ".wav";
+    m_midiDisplay.setWaveformThreshold(analyzedTake.waveformThresholdGain, false);
+    m_midiDisplay.setWaveform(analyzedTake.waveform, false);
+    m_midiDisplay.setAnalyzedTake(analyzedTake);
 
-    juce::File newestFile;
-    for (juce::File childFile : newMidiDirectory.findChildFiles(juce::File::TypesOfFileToFind::findFiles, false))
-    {
-        if (childFile.getFileExtension() == fileExtension)
-        {
-            if (!newestFile.exists())
-            {
-                newestFile = childFile; //initialize first file
-                continue;
-            }
+    if (analyzedTake.error.isNotEmpty())
+        detectNewMidiLog.setText(analyzedTake.error);
+    else
+        detectNewMidiLog.setText(jString() + "newestFile: " + analyzedTake.take.getFileName());
+    if (analyzedTake.readFromResultFile)
+        debugLog("takeAnalyzed::readResultFile: " + TakeResultFile::getResultFile(analyzedTake.take).getFileName());
+    if (analyzedTake.resultFileError.isNotEmpty())
+        debugLog("takeAnalyzed::resultFileError: " + analyzedTake.resultFileError);
+    debugLog("takeAnalyzed::generation: " + juce::String(analyzedTake.generation) + ", ms: " + juce::String(analyzedTake.msAnalysis, 1));
+    debugPlugin("analyzeFile");
+}
 
-            if (childFile.getCreationTime() > newestFile.getCreationTime())
-                newestFile = childFile;
-        }
+void TimeAnalyzerAudioProcessorEditor::analyzeFolder()
+{
+    if (quantizedMidi.isEmpty())
+    {
+        detectNewMidiLog.setText("Please Set a Quantized Midi File");
+        return;
     }
 
-    if (midiFile)
+    if (!updateDirectoryIndex())
     {
-        if (!canReadMidiFile(newestFile))
-            return juce::File();
+        detectNewMidiLog.setText("Can't find midi folder");
+        return;
     }
-    else
+    juce::File midiDirectory = m_directoryIndex.getDirectory();
+
+    setPlayHeadInfo();
+
+    bool audioTakes = analyzeAudioFiles_Toggle.getToggleState();
+    juce::Array<juce::File> takes = m_directoryIndex.getTakes(audioTakes ? DirectoryIndex::Format::audio : DirectoryIndex::Format::midi);
+    takes.removeAllInstancesOf(m_quantizedMidiFile);
+    if (takes.isEmpty())
     {
-        if (!canReadAudioFile(newestFile))
-            return juce::File();
+        detectNewMidiLog.setText("No takes in " + midiDirectory.getFileName());
+        return;
     }
 
-    return newestFile;
+    m_batchID++;
+    m_batchSize = takes.size();
+    m_batchFinished = 0;
+    m_batchResults.clear();
+    for (auto& take : takes)
+        m_batchResults.add(take.getFileName() + ": ...");
+    m_batchSummary = TimingSummary();
+
+    batchResults_Toggle.setToggleState(true, juce::sendNotification);
+    analyzeFolder_Button.setButtonText("Cancel");
+    updateBatchResults();
+
+    juce::Component::SafePointer<TimeAnalyzerAudioProcessorEditor> editor(this);
+    int batchID = m_batchID;
+    m_batchAnalyzer.setUseResultFiles(saveResults_Toggle.getToggleState());
+    m_batchAnalyzer.start(takes, quantizedMidi, MidiMatcher::parsePitchGroups(pitchGroups_Editor.getText()), getAnalysisSettings(),
+        [editor, batchID](int index, const TakeResult& result)
+        {
+            juce::String resultText = result.toString();
+            TimingSummary summary = result.statistics.total;
+            juce::MessageManager::callAsync([editor, batchID, index, resultText, summary]()
+            {
+                if (editor != nullptr && editor->m_batchID == batchID)
+                    editor->addBatchResult(index, resultText, summary);
+            });
+        });
+    debugLog("analyzeFolder::takes: " + juce::String(takes.size()) + ", threads: " + juce::String(m_batchAnalyzer.getNumThreads()));
 }
 
-bool TimeAnalyzerAudioProcessorEditor::canReadMidiFile(juce::File fileOfMidi)
+void TimeAnalyzerAudioProcessorEditor::cancelBatch()
 {
-    juce::FileInputStream inputStream(fileOfMidi);
-    if (inputStream.failedToOpen())
-    {
-        detectNewMidiLog.setText(jString() + "Can't open input stream for " + fileOfMidi.getFileName());
+    m_batchAnalyzer.cancel();
+    m_batchID++;
+    analyzeFolder_Button.setButtonText("Analyze Folder");
+    detectNewMidiLog.setText("Cancelled after " + juce::String(m_batchFinished) + "/" + juce::String(m_batchSize) + " takes");
+}
+
+void TimeAnalyzerAudioProcessorEditor::addBatchResult(int index, const juce::String& result, const TimingSummary& summary)
+{
+    m_batchResults.set(index, result);
+    m_batchSummary.merge(summary);
+    m_batchFinished++;
+    if (m_batchFinished == m_batchSize)
+        analyzeFolder_Button.setButtonText("Analyze Folder");
+    updateBatchResults();
+}
+
+void TimeAnalyzerAudioProcessorEditor::updateBatchResults()
+{
+    detectNewMidiLog.setText("Analyzed " + juce::String(m_batchFinished) + "/" + juce::String(m_batchSize) + " takes");
+    batchResults_Display.setText("all takes: " + m_batchSummary.toString() + "\n\n" + m_batchResults.joinIntoString("\n"), false);
+}
+
+juce::File TimeAnalyzerAudioProcessorEditor::getNewFile(bool midiFile)
+{
+    if (!updateDirectoryIndex())
+        return juce::File();
+
+    TimerBench timerBench("Find New File Time");
+    juce::File newFile = m_directoryIndex.getNewest(midiFile ? DirectoryIndex::Format::midi : DirectoryIndex::Format::audio);
+    debugLog(timerBench.StopAndGetTime());
+    debugLog("getNewFile::takes: " + juce::String(m_directoryIndex.getNumTakes()) + ", parses: " + juce::String(m_directoryIndex.getNumParses()));
+    return newFile;
+}
+
+bool TimeAnalyzerAudioProcessorEditor::updateDirectoryIndex()
+{
+    juce::File midiDirectory(midiDirectory_Editor.getText().unquoted());
+    bool recursive = includeSubfolders_Toggle.getToggleState();
+    bool watched = m_directoryWatcher.isWatching() && m_directoryWatcher.getDirectory() == midiDirectory
+                && m_directoryWatcher.isRecursive() == recursive;
+    if (watched)
+        return m_directoryIndex.setDirectory(midiDirectory, recursive, false);
+
+    bool indexChanged = midiDirectory != m_directoryIndex.getDirectory() || recursive != m_directoryIndex.isRecursive();
+    if (!m_directoryIndex.setDirectory(midiDirectory, recursive))
         return false;
-    }
+    if (!indexChanged)
+        m_directoryIndex.rescan();
+    return true;
+}
+
+bool TimeAnalyzerAudioProcessorEditor::canReadMidiFile(juce::File fileOfMidi)
+{
     juce::MidiFile midiFile;
-    if (!midiFile.readFrom(inputStream))
+    if (!AnalysisCore::getMidiFile(fileOfMidi, midiFile))
     {
         detectNewMidiLog.setText(jString() + "Can't read midi for " + fileOfMidi.getFileName());
         return false;
@@ -175,17 +365,7 @@ bool TimeAnalyzerAudioProcessorEditor::canReadMidiFile(juce::File fileOfMidi)
 
 bool TimeAnalyzerAudioProcessorEditor::getMidiFile(juce::File fileOfMidi, juce::MidiFile& out)
 {
-    juce::FileInputStream inputStream(fileOfMidi);
-    if (inputStream.failedToOpen())
-    {
-        return false;
-    }
-    out.clear();
-    if (!out.readFrom(inputStream))
-    {
-        return false;
-    }
-    return true;
+    return AnalysisCore::getMidiFile(fileOfMidi, out);
 }
 
 void TimeAnalyzerAudioProcessorEditor::readMidiFile(juce::MidiFile midiFile, vArray<MidiEvent>& out)
@@ -193,102 +373,136 @@ void TimeAnalyzerAudioProcessorEditor::readMidiFile(juce::MidiFile midiFile, vAr
     if (midiFile.getNumTracks() == 0)
         return;
 
-    double currentBpm;
-    if (editTempo_Toggle.getToggleState())
-        currentBpm = tempo_Editor.getText().getDoubleValue();
-    else
-        currentBpm = playHeadTempo.getText().getDoubleValue();
+    double currentBpm = getCurrentBpm();
     debugLog("readMidiFile::currentBpm: " + juce::String(currentBpm));
     debugLog("readMidiFile::getTimeFormat: " + juce::String(midiFile.getTimeFormat()));
 
     TimerBench timerBench("Read Midi File Time");
-    for (int i = 0; i < midiFile.getNumTracks(); i++)
-    {
-        for (auto sequence : *midiFile.getTrack(i))
-        {
-            if (sequence->message.isNoteOn())
-            {
-                out.add(MidiEvent(*sequence, currentBpm, midiFile.getTimeFormat()));
-                debugLog("readMidiFile::message.ms: " + juce::String(out.getLast().debugMS));
-            }
-        }
-    }
+    int firstNewEvent = out.size();
+    AnalysisCore::readMidiFile(midiFile, currentBpm, out);
+    for (int i = firstNewEvent; i < out.size(); i++)
+        debugLog("readMidiFile::message.ms: " + juce::String(out[i].debugMS));
     debugLog(timerBench.StopAndGetTime());
 }
 
 bool TimeAnalyzerAudioProcessorEditor::canReadAudioFile(juce::File audioFile)
 {
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    juce::AudioFormatReader* reader = formatManager.createReaderFor(audioFile);
-    if (reader == nullptr)
+    juce::String error;
+    if (!audioProcessor.audioDecoder.canReadAudioFile(audioFile, error))
     {
-        delete reader;
-        detectNewMidiLog.setText(jString() + "Can't create reader for " + audioFile.getFileName());
+        detectNewMidiLog.setText(error);
         return false;
     }
-    if (reader->lengthInSamples > maxAudioFileMinuteLength * 60 * reader->sampleRate)
-    {
-        delete reader;
-        detectNewMidiLog.setText(jString() + "File length exceeded for " + audioFile.getFileName());
-        return false;
-    }
-
-    delete reader;
     return true;
 }
 
-void TimeAnalyzerAudioProcessorEditor::readAudioFile(juce::File audioFile, vArray<MidiEvent>& out)
+double TimeAnalyzerAudioProcessorEditor::getCurrentBpm()
 {
-    if (!audioFile.exists())
-        return;
+    if (editTempo_Toggle.getToggleState())
+        return tempo_Editor.getText().getDoubleValue();
+    return playHeadTempo.getText().getDoubleValue();
+}
 
-    double currentBpm;
+std::shared_ptr<const TempoMap> TimeAnalyzerAudioProcessorEditor::getTempoMap()
+{
     if (editTempo_Toggle.getToggleState())
-        currentBpm = tempo_Editor.getText().getDoubleValue();
-    else
-        currentBpm = playHeadTempo.getText().getDoubleValue();
-    debugLog("readAudioFile::currentBpm: " + juce::String(currentBpm));
+        return nullptr;
+    return m_tempoMap;
+}
 
-    TimerBench timerBench("Read Audio File Time");
+AnalysisSettings TimeAnalyzerAudioProcessorEditor::getAnalysisSettings()
+{
+    AnalysisSettings settings;
+    settings.bpm = getCurrentBpm();
+    settings.tempoMap = getTempoMap();
+    settings.timeSignatureNumerator = m_midiDisplay.timeSignature.numerator;
+    settings.recordBeatStart = m_midiDisplay.getRecordBeatStart();
+    settings.msTimeThreshold = msTimeThreshold_Editor.getText().getDoubleValue();
+    settings.oneToOneAlignment = oneToOneAlignment_Toggle.getToggleState();
+    settings.msAlignmentWindow = msAlignmentWindow_Editor.getText().getDoubleValue();
+    settings.audioDBThreshold = (float)audioDBThreshold_Slider.getValue();
+    settings.audioHitDistanceMS = audioHitDistance_Editor.getText().getIntValue();
+    settings.audioPerChannel = audioPerChannel_Toggle.getToggleState();
+    settings.audioThreads = audioProcessor.audioDecoder.getNumScanThreads();
+    if (audioDetector_ComboBox.getSelectedId() == 2)
+        settings.audioDetector = AnalysisSettings::AudioDetector::spectralFlux;
+    return settings;
+}
 
-    juce::AudioFormatManager formatManager;
-    formatManager.registerBasicFormats();
-    juce::AudioFormatReader* reader = formatManager.createReaderFor(audioFile);
-    if (reader == nullptr)
+void TimeAnalyzerAudioProcessorEditor::setLiveInput(bool liveInput)
+{
+    audioProcessor.liveAudioEnabled = analyzeAudioFiles_Toggle.getToggleState();
+    audioProcessor.liveInputEnabled = liveInput;
+    audioProcessor.liveHits.clear();
+    if (liveInput)
     {
-        delete reader;
-        detectNewMidiLog.setText("Can't read audio file");
-        return;
+        //a take that is being analyzed would replace the live hits
+        m_analysisWorker.cancel();
+        //a new reference starts the live score over
+        m_liveReferenceDirty = true;
+        updateLiveReference();
+        LiveScore liveScore;
+        m_midiDisplay.setLiveScore(&liveScore, false);
+        m_midiDisplay.setWaveform(nullptr, false);
+        m_midiDisplay.clearAnalyzedMidi(true);
+        m_liveInputTimer.startTimer(30);
     }
-
-    juce::AudioBuffer<float> audioBuffer;
-    audioBuffer.setSize(reader->numChannels, reader->lengthInSamples);
-    if (!reader->read(&audioBuffer, 0, reader->lengthInSamples, 0, true, true))
+    else
     {
-        delete reader;
-        detectNewMidiLog.setText("Can't read audio file");
-        return;
+        m_liveInputTimer.stopTimer();
+        m_midiDisplay.setLiveScore(nullptr, false);
+        analyzeFile();
     }
+}
 
-    float dBThreshold = audioDBThreshold_Slider.getValue();
-    int hitDistanceMS = audioHitDistance_Editor.getText().getIntValue();
-    int hitDistanceSamples = reader->sampleRate * (hitDistanceMS / 1000.f);
-    int samplesSinceLastHit = 0;
-    for (int sample = 0; sample < audioBuffer.getNumSamples(); sample++)
+void TimeAnalyzerAudioProcessorEditor::addLiveHits()
+{
+    audioProcessor.liveAudioEnabled = analyzeAudioFiles_Toggle.getToggleState();
+    audioProcessor.liveDBThreshold = (float)audioDBThreshold_Slider.getValue();
+    audioProcessor.liveHitDistanceMS = audioHitDistance_Editor.getText().getIntValue();
+
+    //the hits are placed relative to the record start like the hits of a take
+    double bpm = getCurrentBpm();
+    double recordBeatStart = m_midiDisplay.getRecordBeatStart();
+    std::shared_ptr<const TempoMap> tempoMap = getTempoMap();
+    vArray<MidiEvent> liveMidi;
+    audioProcessor.liveHits.popAll([&](const TimeAnalyzerAudioProcessor::LiveHit& hit)
     {
-        float dBVolume = juce::Decibels::gainToDecibels<float>(audioBuffer.getSample(0, sample));
-        if (dBVolume > dBThreshold && (samplesSinceLastHit > hitDistanceSamples || out.isEmpty()))
-        {
-            out.add(MidiEvent(sample / reader->sampleRate * 1000, currentBpm));
-            samplesSinceLastHit = 0;
-        }
-        samplesSinceLastHit++;
-    }
-    auto audiolength = audioBuffer.getNumSamples() / reader->sampleRate;
+        if (bpm <= 0)
+            return;
+        double ms = (hit.ppqPosition - recordBeatStart) * 60000 / bpm;
+        if (tempoMap != nullptr)
+            ms = tempoMap->tickToMS(hit.ppqPosition * g_defaultQuarterNoteTicks) - tempoMap->tickToMS(recordBeatStart * g_defaultQuarterNoteTicks);
+        //note-ons only match their own pitch group like the notes of a midi take
+        MidiEvent midi = hit.note >= 0 ? MidiEvent(ms, bpm, false, hit.note) : MidiEvent(ms, bpm);
+        //the host beat is already on the tempo map
+        if (tempoMap != nullptr)
+            midi.tickStart = midi.tickEnd = (hit.ppqPosition - recordBeatStart) * g_defaultQuarterNoteTicks;
+        liveMidi.add(midi);
+    });
+    if (!liveMidi.isEmpty())
+        m_midiDisplay.addAnalyzedMidi(liveMidi);
+
+    updateLiveReference();
+    LiveScore liveScore;
+    if (audioProcessor.liveScore.read(liveScore))
+        m_midiDisplay.setLiveScore(&liveScore, true);
+}
 
-    delete reader;
-    debugLog(timerBench.StopAndGetTime());
+void TimeAnalyzerAudioProcessorEditor::updateLiveReference()
+{
+    audioProcessor.liveReference.collectGarbage();
+    double recordBeatStart = m_midiDisplay.getRecordBeatStart();
+    if (!m_liveReferenceDirty && recordBeatStart == m_liveReferenceRecordStart)
+        return;
+
+    m_liveReferenceDirty = false;
+    m_liveReferenceRecordStart = recordBeatStart;
+    //for the reference the processor builds when the state is loaded without the editor
+    audioProcessor.stateInfo.setProperty(NAME_OF(m_liveReferenceRecordStart), m_liveReferenceRecordStart, nullptr);
+    audioProcessor.liveReference.set(std::make_unique<LiveReference>(quantizedMidi, MidiMatcher::parsePitchGroups(pitchGroups_Editor.getText()),
+                                                                     recordBeatStart, msTimeThreshold_Editor.getText().getDoubleValue(),
+                                                                     getTempoMap()));
 }
 
 juce::String TimeAnalyzerAudioProcessorEditor::getMidiNoteName(juce::MidiMessage message)
@@ -324,14 +538,13 @@ juce::String TimeAnalyzerAudioProcessorEditor::getMidiNoteName(int note)
 
 void TimeAnalyzerAudioProcessorEditor::setPlayHeadInfo()
 {
-    auto playHead = audioProcessor.getPlayHead();
+    updateTransport();
     double previousTempo = playHeadTempo.getText().getDoubleValue();
-    if (playHead && audioProcessor.audioProcessCount > 0)
+    if (m_transport.numBlocks > 0)
     {
-
-        double newTempo = *playHead->getPosition()->getBpm();
+        double newTempo = m_transport.bpm;
         playHeadTempo.setText(juce::String(newTempo));
-        m_midiDisplay.timeSignature = *playHead->getPosition()->getTimeSignature();
+        m_midiDisplay.timeSignature = m_transport.timeSignature;
 
         if (previousTempo != newTempo)
             m_midiDisplay.setBpm(newTempo, true);
@@ -341,6 +554,26 @@ void TimeAnalyzerAudioProcessorEditor::setPlayHeadInfo()
     debugLog("setPlayHeadInfo::m_midiDisplay.timeSignature: " + juce::String(m_midiDisplay.timeSignature.numerator) + "/" + juce::String(m_midiDisplay.timeSignature.denominator));
 }
 
+void TimeAnalyzerAudioProcessorEditor::updateTransport()
+{
+    audioProcessor.transportState.read(m_transport);
+    if (!m_transport.isRecording && m_pendingNewFile != juce::File())
+        newFileWritten(m_pendingNewFile);
+
+    if (!autoRecordStart_Toggle.getToggleState() || m_transport.numRecordStarts == 0 || m_transport.numRecordStarts == m_numRecordStarts)
+        return;
+
+    //the record start is in measures after the measure start
+    m_numRecordStarts = m_transport.numRecordStarts;
+    double recordStartMeasure = m_transport.recordStartPpq / juce::jmax(1, m_transport.timeSignature.numerator)
+                              - measureStart_Editor.getText().getDoubleValue();
+    if (getTempoMap() != nullptr)
+        recordStartMeasure = getTempoMap()->tickToMeasure(m_transport.recordStartPpq * g_defaultQuarterNoteTicks)
+                           - measureStart_Editor.getText().getDoubleValue();
+    recordStartMeasure_Editor.setText(juce::String(recordStartMeasure), true);
+    debugLog("updateTransport::recordStartPpq: " + juce::String(m_transport.recordStartPpq));
+}
+
 void TimeAnalyzerAudioProcessorEditor::debugTree(juce::ValueTree& tree)
 {
     for (int i = 0; i < tree.getNumProperties(); i++)
@@ -374,16 +607,23 @@ void TimeAnalyzerAudioProcessorEditor::debugPlugin(juce::String callFrom)
 
     debugText += m_midiDisplay.debugMidiDisplay() + "\n";
 
-    debugText += "Play Head is Null: " + juce::String((int)(audioProcessor.getPlayHead() == nullptr)) + "\n";
-    debugText += "audioProcessCount: " + juce::String(audioProcessor.audioProcessCount) + "\n";
+    debugText += "Host Has Position: " + juce::String((int)m_transport.hasPpqPosition) + "\n";
+    debugText += "transport blocks: " + juce::String(m_transport.numBlocks) + "\n";
+    debugText += "host record start (ppq): " + juce::String(m_transport.recordStartPpq) + "\n";
     debugText += "\n";
 
     debugText += "msTimeThreshold_Editor: " + msTimeThreshold_Editor.getText() + "\n";
+    debugText += "msAlignmentWindow_Editor: " + msAlignmentWindow_Editor.getText() + "\n";
     debugText += "playHeadTempo: " + playHeadTempo.getText() + "\n";
+    debugText += "m_tempoMap: " + (m_tempoMap != nullptr ? juce::String(m_tempoMap->getNumTempoChanges()) + " tempos, "
+                                                          + juce::String(m_tempoMap->getNumMeterChanges()) + " meters" : juce::String("none")) + "\n";
     debugText += "tempo_Editor: " + tempo_Editor.getText() + "\n";
     debugText += "measureStart_Editor: " + measureStart_Editor.getText() + "\n";
     debugText += "measureRangeLength_Editor: " + measureRangeLength_Editor.getText() + "\n";
+    debugText += "pitchGroups_Editor: " + pitchGroups_Editor.getText() + "\n";
     debugText += "midiDirectory_Editor: " + midiDirectory_Editor.getText() + "\n";
+    debugText += "m_directoryIndex: " + juce::String(m_directoryIndex.getNumTakes()) + " takes, "
+               + juce::String(m_directoryIndex.getNumParses()) + " parses\n";
     debugText += "detectNewMidiFrequency_Editor: " + detectNewMidiFrequency_Editor.getText() + "\n";
     debugText += "m_msDetectNewMidiFrequency: " + juce::String(m_msDetectNewMidiFrequency) + "\n\n";
 
@@ -414,6 +654,12 @@ void TimeAnalyzerAudioProcessorEditor::loadStateInfo()
         msTimeThreshold_Editor.setText("", false);
     }
 
+    oneToOneAlignment_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(oneToOneAlignment_Toggle), false), juce::dontSendNotification);
+    msAlignmentWindow_Editor.setText(audioProcessor.stateInfo.getProperty(NAME_OF(msAlignmentWindow_Editor), "100"), false);
+    msAlignmentWindow_Title.setVisible(oneToOneAlignment_Toggle.getToggleState());
+    msAlignmentWindow_Editor.setVisible(oneToOneAlignment_Toggle.getToggleState());
+    m_midiDisplay.setAlignmentMode(oneToOneAlignment_Toggle.getToggleState(), msAlignmentWindow_Editor.getText().getDoubleValue(), false);
+
     editTempo_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(editTempo_Toggle)), true);
     juce::var loadTempoEdit = audioProcessor.stateInfo.getProperty(NAME_OF(tempo_Editor));
     if (!loadTempoEdit.isVoid())
@@ -426,6 +672,8 @@ void TimeAnalyzerAudioProcessorEditor::loadStateInfo()
     {
         measureStart_Editor.setText("0", false);
     }
+    autoRecordStart_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(autoRecordStart_Toggle), false), juce::dontSendNotification);
+    recordStartMeasure_Editor.setReadOnly(autoRecordStart_Toggle.getToggleState());
 
     juce::var loadRecordStartMeasure = audioProcessor.stateInfo.getProperty(NAME_OF(recordStartMeasure_Editor));
     if (!loadRecordStartMeasure.isVoid())
@@ -452,14 +700,20 @@ void TimeAnalyzerAudioProcessorEditor::loadStateInfo()
         measureRangeLength_Editor.setText("", false);
     }
 
-    midiDirectory_Editor.setText(audioProcessor.stateInfo.getProperty(NAME_OF(midiDirectory_Editor)), false);
+    pitchGroups_Editor.setText(audioProcessor.stateInfo.getProperty(NAME_OF(pitchGroups_Editor)), false);
+    m_midiDisplay.setPitchGroups(MidiMatcher::parsePitchGroups(pitchGroups_Editor.getText()), false);
 
-    detectNewMidi_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(detectNewMidi_Toggle)), true);
+    midiDirectory_Editor.setText(audioProcessor.stateInfo.getProperty(NAME_OF(midiDirectory_Editor)), false);
+    includeSubfolders_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(includeSubfolders_Toggle), false), juce::dontSendNotification);
+    saveResults_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(saveResults_Toggle), false), juce::dontSendNotification);
 
     juce::var loadFrequency = audioProcessor.stateInfo.getProperty(NAME_OF(detectNewMidiFrequency_Editor));
     if (!loadFrequency.isVoid() && (int)loadFrequency > 0)
         m_msDetectNewMidiFrequency = loadFrequency;
     detectNewMidiFrequency_Editor.setText(juce::String(m_msDetectNewMidiFrequency));
+    detectNewMidi_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(detectNewMidi_Toggle)), true);
+    //the toggle only notifies when it changed, the folder or frequency might have changed too
+    updateDirectoryWatcher();
 
     juce::var quantizedMidiFilePath = audioProcessor.stateInfo.getProperty(NAME_OF(m_quantizedMidiFile));
     if (!quantizedMidiFilePath.isVoid())
@@ -477,9 +731,17 @@ void TimeAnalyzerAudioProcessorEditor::loadStateInfo()
     audioDBThreshold_Slider.setVisible(analyzeAudioFiles_Toggle.getToggleState());
     audioHitDistance_Title.setVisible(analyzeAudioFiles_Toggle.getToggleState());
     audioHitDistance_Editor.setVisible(analyzeAudioFiles_Toggle.getToggleState());
+    audioPerChannel_Toggle.setVisible(analyzeAudioFiles_Toggle.getToggleState());
+    audioDetector_ComboBox.setVisible(analyzeAudioFiles_Toggle.getToggleState());
 
+    audioDetector_ComboBox.setSelectedId(audioProcessor.stateInfo.getProperty(NAME_OF(audioDetector_ComboBox), 1), juce::dontSendNotification);
     audioDBThreshold_Slider.setValue(audioProcessor.stateInfo.getProperty(NAME_OF(audioDBThreshold_Slider), 0), juce::dontSendNotification);
     audioHitDistance_Editor.setText(audioProcessor.stateInfo.getProperty(NAME_OF(audioHitDistance_Editor), "50"), false);
+    audioPerChannel_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(audioPerChannel_Toggle), false), juce::dontSendNotification);
+    midiFeedback_ComboBox.setSelectedId(audioProcessor.stateInfo.getProperty(NAME_OF(midiFeedback_ComboBox), 1), juce::sendNotificationSync);
+    liveInput_Toggle.setToggleState(audioProcessor.stateInfo.getProperty(NAME_OF(liveInput_Toggle), false), juce::dontSendNotification);
+    if (liveInput_Toggle.getToggleState())
+        setLiveInput(true);
     #pragma endregion
 
     loadStateCount++;
@@ -502,7 +764,8 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
     debug_Toggle.onClick = [&]()
     {
         debug_Display.setVisible(debug_Toggle.getToggleState());
-        m_midiDisplay.setVisible(!debug_Toggle.getToggleState());
+        m_midiDisplay.setVisible(!debug_Toggle.getToggleState() && !batchResults_Toggle.getToggleState());
+        batchResults_Display.setVisible(!debug_Toggle.getToggleState() && batchResults_Toggle.getToggleState());
         audioProcessor.stateInfo.setProperty(NAME_OF(debug_Toggle), debug_Toggle.getToggleState(), nullptr);
     };
     addAndMakeVisible(debugClear_Button);
@@ -526,6 +789,24 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
     {
         audioProcessor.stateInfo.setProperty(NAME_OF(msTimeThreshold_Editor), msTimeThreshold_Editor.getText(), nullptr);
         m_midiDisplay.setTimeThreshold(msTimeThreshold_Editor.getText().getDoubleValue(), true);
+        m_liveReferenceDirty = true;
+    };
+
+    addAndMakeVisible(oneToOneAlignment_Toggle);
+    oneToOneAlignment_Toggle.onClick = [&]()
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(oneToOneAlignment_Toggle), oneToOneAlignment_Toggle.getToggleState(), nullptr);
+        msAlignmentWindow_Title.setVisible(oneToOneAlignment_Toggle.getToggleState());
+        msAlignmentWindow_Editor.setVisible(oneToOneAlignment_Toggle.getToggleState());
+        m_midiDisplay.setAlignmentMode(oneToOneAlignment_Toggle.getToggleState(), msAlignmentWindow_Editor.getText().getDoubleValue(), true);
+    };
+    addAndMakeVisible(msAlignmentWindow_Title);
+    addAndMakeVisible(msAlignmentWindow_Editor);
+    msAlignmentWindow_Editor.setSelectAllWhenFocused(true);
+    msAlignmentWindow_Editor.onTextChange = [&]()
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(msAlignmentWindow_Editor), msAlignmentWindow_Editor.getText(), nullptr);
+        m_midiDisplay.setAlignmentMode(oneToOneAlignment_Toggle.getToggleState(), msAlignmentWindow_Editor.getText().getDoubleValue(), true);
     };
 
     #pragma region Tempo
@@ -540,6 +821,9 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
     {
         audioProcessor.stateInfo.setProperty(NAME_OF(editTempo_Toggle), editTempo_Toggle.getToggleState(), nullptr);
         tempo_Editor.setVisible(editTempo_Toggle.getToggleState());
+        //an edited tempo replaces the tempo changes of the quantized midi
+        m_midiDisplay.setTempoMap(getTempoMap(), true);
+        m_liveReferenceDirty = true;
     };
 
     addAndMakeVisible(tempo_Editor);
@@ -561,6 +845,17 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
             audioProcessor.stateInfo.setProperty(NAME_OF(recordStartMeasure_Editor), 
                                                  lockAnalyzedMidi_Toggle.getToggleState() ? jString(m_previousRecordStart) : recordStartMeasure_Editor.getText(), nullptr);
             m_midiDisplay.setRecordStart(recordStartMeasure_Editor.getText().getDoubleValue(), true);
+            //audio hits are placed on the tempo changes from the record start, so they have to be read again
+            if (getTempoMap() != nullptr && analyzeAudioFiles_Toggle.getToggleState() && newestFile.existsAsFile())
+                analyzeFile();
+        };
+        addAndMakeVisible(autoRecordStart_Toggle);
+        autoRecordStart_Toggle.onClick = [this]
+        {
+            audioProcessor.stateInfo.setProperty(NAME_OF(autoRecordStart_Toggle), autoRecordStart_Toggle.getToggleState(), nullptr);
+            //the record start follows the record-in of the host instead of being typed
+            recordStartMeasure_Editor.setReadOnly(autoRecordStart_Toggle.getToggleState());
+            updateTransport();
         };
         
         addAndMakeVisible(measureStart_Title);
@@ -616,6 +911,17 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
         };
     }
 
+    addAndMakeVisible(pitchGroups_Title);
+    addAndMakeVisible(pitchGroups_Editor);
+    pitchGroups_Editor.setSelectAllWhenFocused(true);
+    pitchGroups_Editor.setTextToShowWhenEmpty("42 44 46, 38 40", juce::Colours::grey);
+    pitchGroups_Editor.onTextChange = [&]()
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(pitchGroups_Editor), pitchGroups_Editor.getText(), nullptr);
+        m_midiDisplay.setPitchGroups(MidiMatcher::parsePitchGroups(pitchGroups_Editor.getText()), true);
+        m_liveReferenceDirty = true;
+    };
+
     addAndMakeVisible(midiDirectory_Title);
     addAndMakeVisible(midiDirectory_Editor);
     midiDirectory_Editor.setSelectAllWhenFocused(true);
@@ -623,6 +929,16 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
     {
         audioProcessor.stateInfo.setProperty(NAME_OF(midiDirectory_Editor), midiDirectory_Editor.getText(), nullptr);
     };
+    //the folder is watched once it's entered, not on every key while it's typed
+    midiDirectory_Editor.onReturnKey = [&]() { updateDirectoryWatcher(); };
+    midiDirectory_Editor.onFocusLost = [&]() { updateDirectoryWatcher(); };
+
+    addAndMakeVisible(includeSubfolders_Toggle);
+    includeSubfolders_Toggle.onClick = [&]()
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(includeSubfolders_Toggle), includeSubfolders_Toggle.getToggleState(), nullptr);
+        updateDirectoryWatcher();
+    };
 
     addAndMakeVisible(setQuantizedMidiFile_Button);
     setQuantizedMidiFile_Button.onClick = [&]() { setQuantizedMidiFile(getNewFile()); };
@@ -636,6 +952,36 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
         analyzeFile(getNewFile(!analyzeAudioFiles_Toggle.getToggleState()));
     };
 
+    #pragma region Batch
+    addAndMakeVisible(analyzeFolder_Button);
+    analyzeFolder_Button.onClick = [this]
+    {
+        if (m_batchAnalyzer.isRunning())
+            cancelBatch();
+        else
+            analyzeFolder();
+    };
+
+    addAndMakeVisible(saveResults_Toggle);
+    saveResults_Toggle.onClick = [this]
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(saveResults_Toggle), saveResults_Toggle.getToggleState(), nullptr);
+    };
+
+    addAndMakeVisible(batchResults_Display);
+    batchResults_Display.setMultiLine(true, false);
+    batchResults_Display.setReadOnly(true);
+    batchResults_Display.setFont(getMonoFont());
+    batchResults_Display.setVisible(false);
+
+    addAndMakeVisible(batchResults_Toggle);
+    batchResults_Toggle.onClick = [this]
+    {
+        batchResults_Display.setVisible(batchResults_Toggle.getToggleState() && !debug_Toggle.getToggleState());
+        m_midiDisplay.setVisible(!batchResults_Toggle.getToggleState() && !debug_Toggle.getToggleState());
+    };
+    #pragma endregion
+
     #pragma region Audio Analyzing
     addAndMakeVisible(analyzeAudioFiles_Toggle);
     analyzeAudioFiles_Toggle.onClick = [this]
@@ -645,6 +991,18 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
         audioDBThreshold_Slider.setVisible(analyzeAudioFiles_Toggle.getToggleState());
         audioHitDistance_Title.setVisible(analyzeAudioFiles_Toggle.getToggleState());
         audioHitDistance_Editor.setVisible(analyzeAudioFiles_Toggle.getToggleState());
+        audioPerChannel_Toggle.setVisible(analyzeAudioFiles_Toggle.getToggleState());
+        audioDetector_ComboBox.setVisible(analyzeAudioFiles_Toggle.getToggleState());
+    };
+
+    addAndMakeVisible(audioDetector_ComboBox);
+    audioDetector_ComboBox.addItem("Amplitude", 1);
+    audioDetector_ComboBox.addItem("Spectral Flux", 2);
+    audioDetector_ComboBox.setSelectedId(1, juce::dontSendNotification);
+    audioDetector_ComboBox.onChange = [this]
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(audioDetector_ComboBox), audioDetector_ComboBox.getSelectedId(), nullptr);
+        analyzeFile();
     };
 
     addAndMakeVisible(audioDBThreshold_Title);
@@ -667,6 +1025,33 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
         audioProcessor.stateInfo.setProperty(NAME_OF(audioHitDistance_Editor), audioHitDistance_Editor.getText(), nullptr);
         analyzeFile();
     };
+
+    addAndMakeVisible(liveInput_Toggle);
+    liveInput_Toggle.onClick = [this]
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(liveInput_Toggle), liveInput_Toggle.getToggleState(), nullptr);
+        setLiveInput(liveInput_Toggle.getToggleState());
+    };
+    m_liveInputTimer.callback = [this]() { addLiveHits(); };
+
+    addAndMakeVisible(midiFeedback_ComboBox);
+    midiFeedback_ComboBox.addItem("No Feedback", 1);
+    midiFeedback_ComboBox.addItem("Feedback CC", 2);
+    midiFeedback_ComboBox.addItem("Feedback Notes", 3);
+    midiFeedback_ComboBox.setSelectedId(1, juce::dontSendNotification);
+    midiFeedback_ComboBox.onChange = [this]
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(midiFeedback_ComboBox), midiFeedback_ComboBox.getSelectedId(), nullptr);
+        //the live hits are sent to the midi output as the controller or notes of TimeAnalyzerAudioProcessor::MidiFeedback
+        audioProcessor.midiFeedback = TimeAnalyzerAudioProcessor::getMidiFeedback(midiFeedback_ComboBox.getSelectedId());
+    };
+
+    addAndMakeVisible(audioPerChannel_Toggle);
+    audioPerChannel_Toggle.onClick = [this]
+    {
+        audioProcessor.stateInfo.setProperty(NAME_OF(audioPerChannel_Toggle), audioPerChannel_Toggle.getToggleState(), nullptr);
+        analyzeFile();
+    };
     #pragma endregion
 
 
@@ -679,10 +1064,7 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
             detectNewMidiFrequency_Title.setVisible(newState);
             detectNewMidiFrequency_Editor.setVisible(newState);
 
-            if (!newState)
-                stopTimer();
-            else if (!isTimerRunning())
-                startTimer(m_msDetectNewMidiFrequency);
+            updateDirectoryWatcher();
         };
 
         addAndMakeVisible(detectNewMidiFrequency_Title);
@@ -697,17 +1079,16 @@ void TimeAnalyzerAudioProcessorEditor::initializeUI()
             int newFrequency = detectNewMidiFrequency_Editor.getText().getIntValue();
             if (newFrequency > 0 && newFrequency != m_msDetectNewMidiFrequency)
             {
-                if (isTimerRunning())
-                    stopTimer();
-                startTimer(newFrequency);
-
                 m_msDetectNewMidiFrequency = newFrequency;
                 audioProcessor.stateInfo.setProperty(NAME_OF(detectNewMidiFrequency_Editor), newFrequency, nullptr);
             }
         };
+        //restarting the watcher can wait for its thread, so a polling watcher only gets the interval once it's entered.
+        //Events don't need an interval
+        detectNewMidiFrequency_Editor.onReturnKey = [&]() { updateDirectoryWatcher(); };
+        detectNewMidiFrequency_Editor.onFocusLost = [&]() { updateDirectoryWatcher(); };
 
-        if (detectNewMidi_Toggle.getToggleState())
-            startTimer(m_msDetectNewMidiFrequency);
+        updateDirectoryWatcher();
 
         addAndMakeVisible(detectNewMidiLog);
         detectNewMidiLog.setTextToShowWhenEmpty("Log", juce::Colours::grey);
@@ -735,10 +1116,13 @@ void TimeAnalyzerAudioProcessorEditor::resized()
         fitButtonInLeftBounds(tempBounds, setQuantizedMidiFile_Button);
         fitButtonInLeftBounds(tempBounds, refreshQuantizedMidi_Button);
         fitButtonInLeftBounds(tempBounds, analyzeMidiFile_Button);
+        fitButtonInLeftBounds(tempBounds, analyzeFolder_Button);
+        fitButtonInLeftBounds(tempBounds, saveResults_Toggle);
 
         tempBounds.removeFromLeft(10);
 
         fitButtonInLeftBounds(tempBounds, analyzeAudioFiles_Toggle);
+        audioDetector_ComboBox.setBounds(tempBounds.removeFromLeft(110));
 
         fitButtonInLeftBounds(tempBounds, audioDBThreshold_Title);
         audioDBThreshold_Slider.setBounds(tempBounds.removeFromLeft(150));
@@ -747,12 +1131,16 @@ void TimeAnalyzerAudioProcessorEditor::resized()
 
         fitButtonInLeftBounds(tempBounds, audioHitDistance_Title);
         audioHitDistance_Editor.setBounds(tempBounds.removeFromLeft(40));
+        fitButtonInLeftBounds(tempBounds, audioPerChannel_Toggle);
+        fitButtonInLeftBounds(tempBounds, liveInput_Toggle);
+        midiFeedback_ComboBox.setBounds(tempBounds.removeFromLeft(120));
     }
     {
         Bounds tempBounds = bounds.removeFromBottom(30).withHeight(25);
 
         fitButtonInLeftBounds(tempBounds, midiDirectory_Title);
         midiDirectory_Editor.setBounds(tempBounds.removeFromLeft(200));
+        fitButtonInLeftBounds(tempBounds, includeSubfolders_Toggle);
 
         fitButtonInLeftBounds(tempBounds, detectNewMidi_Toggle);
         fitButtonInLeftBounds(tempBounds, detectNewMidiFrequency_Title);
@@ -766,6 +1154,7 @@ void TimeAnalyzerAudioProcessorEditor::resized()
 
         fitButtonInLeftBounds(tempBounds, recordStartMeasure_Title);
         recordStartMeasure_Editor.setBounds(tempBounds.removeFromLeft(40));
+        fitButtonInLeftBounds(tempBounds, autoRecordStart_Toggle);
 
         tempBounds.removeFromLeft(10);
 
@@ -782,6 +1171,11 @@ void TimeAnalyzerAudioProcessorEditor::resized()
 
         fitButtonInLeftBounds(tempBounds, measureRangeLength_Title);
         measureRangeLength_Editor.setBounds(tempBounds.removeFromLeft(30));
+
+        tempBounds.removeFromLeft(10);
+
+        fitButtonInLeftBounds(tempBounds, pitchGroups_Title);
+        pitchGroups_Editor.setBounds(tempBounds.removeFromLeft(120));
     }
     {
         Bounds tempBounds = bounds.removeFromBottom(30).withHeight(25);
@@ -789,6 +1183,7 @@ void TimeAnalyzerAudioProcessorEditor::resized()
         fitButtonInLeftBounds(tempBounds, debug_Toggle);
         fitButtonInLeftBounds(tempBounds, debugClear_Button);
         fitButtonInLeftBounds(tempBounds, debugRefresh_Button);
+        fitButtonInLeftBounds(tempBounds, batchResults_Toggle);
 
         tempBounds.removeFromLeft(10);
 
@@ -801,11 +1196,18 @@ void TimeAnalyzerAudioProcessorEditor::resized()
 
         fitButtonInLeftBounds(tempBounds, msTimeThreshold_Title);
         msTimeThreshold_Editor.setBounds(tempBounds.removeFromLeft(30));
+
+        tempBounds.removeFromLeft(10);
+
+        fitButtonInLeftBounds(tempBounds, oneToOneAlignment_Toggle);
+        fitButtonInLeftBounds(tempBounds, msAlignmentWindow_Title);
+        msAlignmentWindow_Editor.setBounds(tempBounds.removeFromLeft(40));
     }
     bounds.removeFromBottom(10);
 
     m_midiDisplay.setBounds(bounds);
     debug_Display.setBounds(bounds);
+    batchResults_Display.setBounds(bounds);
 }
 
 void TimeAnalyzerAudioProcessorEditor::paint(juce::Graphics& g)
@@ -12,11 +12,15 @@
 #include "PluginProcessor.h"
 #include "MidiEvent.h"
 #include "MidiDisplay.h"
+#include "AnalysisCore.h"
+#include "BatchAnalyzer.h"
+#include "DirectoryIndex.h"
+#include "DirectoryWatcher.h"
 
 //==============================================================================
 /**
 */
-class TimeAnalyzerAudioProcessorEditor  : public juce::AudioProcessorEditor, juce::Timer
+class TimeAnalyzerAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
     TimeAnalyzerAudioProcessorEditor (TimeAnalyzerAudioProcessor&);
@@ -25,28 +29,58 @@ public:
     bool keyPressed(const juce::KeyPress& key) override;
 
     //==============================================================================
-    void timerCallback() override;
+    //watches the midi folder while "Detect New Midi to Analyze" is on, the frequency is the poll interval of folders
+    //that can't be watched with events
+    void updateDirectoryWatcher();
+    //a take in the midi folder was closed after it was written
+    void newFileWritten(juce::File writtenFile);
+    //applies a scan of the midi folder from the watcher thread. After lost events the newest take is handled as
+    //written if it isn't the shown take
+    void directoryScanned(const DirectoryIndex::Scan& scan);
 
     void setQuantizedMidiFile(juce::File quantizedMidiFile);
+    //requests the analysis of the take on the analysis worker, a request cancels the one before it
     void analyzeFile();
     void analyzeFile(juce::File fileToAnalyze);
+    //shows the take the analysis worker finished, on the message thread
+    void takeAnalyzed(const AnalyzedTake& analyzedTake);
 
-    //get midi or audio file
+    //analyzes every take in the midi folder on the batch analyzer, results show up in the batch results as they finish
+    void analyzeFolder();
+    void cancelBatch();
+
+    //the newest midi or audio take of the midi folder that can be read
     juce::File getNewFile(bool midiFile = true);
+    //points the directory index at the midi folder, rescans it unless the directory watcher keeps it up to date.
+    //Returns false if the folder doesn't exist
+    bool updateDirectoryIndex();
 
     bool canReadMidiFile(juce::File fileOfMidi);
     bool getMidiFile(juce::File fileOfMidi, juce::MidiFile& out);
     void readMidiFile(juce::MidiFile midiFile, vArray<MidiEvent>& out);
 
     bool canReadAudioFile(juce::File audioFile);
-    void readAudioFile(juce::File audioFile, vArray<MidiEvent>& out);
 
-    const int maxAudioFileMinuteLength = 10;
+    //the tempo editor when "Edit Tempo" is on, otherwise the host tempo
+    double getCurrentBpm();
+    //the tempo map of the quantized midi, nullptr when "Edit Tempo" is on or the midi has no tempo or meter changes
+    std::shared_ptr<const TempoMap> getTempoMap();
+    //the current state of the editor as settings for AnalysisCore
+    AnalysisSettings getAnalysisSettings();
+
+    //live mode shows the note-ons of the midi input, or the hits of the audio input when audio files are analyzed,
+    //as the processor captures them instead of analyzing files
+    void setLiveInput(bool liveInput);
+    void addLiveHits();
+    //hands the quantized midi and the settings the live hits are scored with to the processor
+    void updateLiveReference();
 
     juce::String getMidiNoteName(juce::MidiMessage message);
     juce::String getMidiNoteName(int note);
 
     void setPlayHeadInfo();
+    //reads the transport state the audio thread published last, and sets the record start at a record-in of the host
+    void updateTransport();
 
     inline static juce::TextEditor* g_debug_Display;
     inline static void debugLog(juce::String log) 
@@ -87,6 +121,9 @@ private:
 
     juce::TextButton msTimeThreshold_Title{ "Time Threshold (ms):" };
     juce::TextEditor msTimeThreshold_Editor;
+    juce::ToggleButton oneToOneAlignment_Toggle{ "One-to-One" };
+    juce::TextButton msAlignmentWindow_Title{ "Window (ms):" };
+    juce::TextEditor msAlignmentWindow_Editor;
 
     juce::TextButton playHeadTempo_Title{ "Tempo:" };
     juce::TextEditor playHeadTempo;
@@ -94,41 +131,83 @@ private:
     juce::TextEditor tempo_Editor;
     juce::TextButton recordStartMeasure_Title{ "Record Start:" };
     juce::TextEditor recordStartMeasure_Editor;
+    juce::ToggleButton autoRecordStart_Toggle{ "From Host" };
     juce::TextButton measureStart_Title{ "Measure Start:" };
     juce::TextEditor measureStart_Editor;
     juce::TextButton measureStartIncrement{ "+" };
     juce::TextButton measureStartDecrement{ "-" };
     juce::ToggleButton lockAnalyzedMidi_Toggle{ "Lock Analyzed Midi" };
     double m_previousRecordStart = 0;
+    TransportState m_transport;
+    CallbackTimer m_transportTimer;
+    //the record-in of the host that the record start was last set from
+    int m_numRecordStarts = 0;
     double m_previousMeasureStart = 0;
     juce::TextButton measureRangeLength_Title{ "Measure Range:" };
     juce::TextEditor measureRangeLength_Editor;
+    juce::TextButton pitchGroups_Title{ "Pitch Groups:" };
+    juce::TextEditor pitchGroups_Editor;
 
     juce::TextButton midiDirectory_Title{ "Midi Folder Path:" };
     juce::TextEditor midiDirectory_Editor;
+    juce::ToggleButton includeSubfolders_Toggle{ "Subfolders" };
+    DirectoryIndex m_directoryIndex;
     juce::ToggleButton detectNewMidi_Toggle{ "Detect New Midi to Analyze" };
     juce::TextButton detectNewMidiFrequency_Title{ "Frequency (ms):" };
     juce::TextEditor detectNewMidiFrequency_Editor;
     juce::TextEditor detectNewMidiLog;
     int m_msDetectNewMidiFrequency;
+    DirectoryWatcher m_directoryWatcher;
+    //written while the host was recording, analyzed when the recording stops
+    juce::File m_pendingNewFile;
+    //the watcher hasn't reported the first scan of the folder yet
+    bool m_directoryScanPending = false;
 
     juce::TextButton setQuantizedMidiFile_Button{ "Set Quantized Midi File" };
     juce::TextButton refreshQuantizedMidi_Button{ "Refresh Quantized Midi" };
     juce::TextButton analyzeMidiFile_Button{ "Analyze Midi File" };
+    juce::TextButton analyzeFolder_Button{ "Analyze Folder" };
+    juce::ToggleButton saveResults_Toggle{ "Save Results" };
+
+    juce::ToggleButton batchResults_Toggle{ "Batch Results" };
+    juce::TextEditor batchResults_Display;
 
     juce::ToggleButton analyzeAudioFiles_Toggle{ "Analyze Audio Files" };
+    juce::ComboBox audioDetector_ComboBox;
     juce::TextButton audioDBThreshold_Title{ "dB Threshold:" };
     juce::Slider audioDBThreshold_Slider;
     juce::TextButton audioHitDistance_Title{ "Hit Distance (ms):" };
     juce::TextEditor audioHitDistance_Editor;
+    juce::ToggleButton audioPerChannel_Toggle{ "Per Channel" };
+    juce::ToggleButton liveInput_Toggle{ "Live Input" };
+    juce::ComboBox midiFeedback_ComboBox;
+    CallbackTimer m_liveInputTimer;
+    //the live reference has to be updated when the quantized midi or a setting it was built with changed
+    bool m_liveReferenceDirty = true;
+    double m_liveReferenceRecordStart = 0;
 
     //==============================================================================
     vArray<MidiEvent> quantizedMidi;
     juce::File m_quantizedMidiFile;
+    std::shared_ptr<const TempoMap> m_tempoMap;
     juce::File newestFile;
     juce::int64 newestFileSize = 0;
-    juce::MidiFile midiFileToAnalyze;
+    juce::File midiFileToAnalyze;
     juce::File audioFileToAnalyze;
+    //reads and matches the take off the message thread, results of a request that a newer one replaced are dropped
+    AnalysisWorker m_analysisWorker;
+
+    //==============================================================================
+    void addBatchResult(int index, const juce::String& result, const TimingSummary& summary);
+    void updateBatchResults();
+
+    BatchAnalyzer m_batchAnalyzer;
+    //results of an older batch that arrive after a new batch started are dropped
+    int m_batchID = 0;
+    int m_batchSize = 0;
+    int m_batchFinished = 0;
+    juce::StringArray m_batchResults;
+    TimingSummary m_batchSummary;
 
     //==============================================================================
 
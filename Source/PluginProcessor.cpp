@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AnalysisCore.h"
 
 //==============================================================================
 TimeAnalyzerAudioProcessor::TimeAnalyzerAudioProcessor()
@@ -93,8 +94,18 @@ void TimeAnalyzerAudioProcessor::changeProgramName (int index, const juce::Strin
 //==============================================================================
 void TimeAnalyzerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
+    //everything the live hit detector needs is allocated here instead of on the audio thread
+    m_liveDBThreshold = liveDBThreshold;
+    m_liveHitDistanceMS = liveHitDistanceMS;
+    m_liveHitDetector = AudioHitDetector(sampleRate, m_liveDBThreshold, m_liveHitDistanceMS);
+    m_liveHitDetector.prepare();
+    m_liveSliceLength = juce::jmax(1, samplesPerBlock);
+    m_liveHitSamples.ensureStorageAllocated(m_liveSliceLength);
+    m_liveChannels.resize((size_t)getTotalNumInputChannels());
+    //an event takes its sample position, its size and 3 bytes of midi
+    const int bytesPerFeedbackEvent = (int)(sizeof(juce::int32) + sizeof(juce::uint16)) + 3;
+    m_midiFeedback.ensureSize((size_t)((maxFeedbackEvents + (int)feedbackNotes.size()) * bytesPerFeedbackEvent));
+    m_feedbackNoteLength = juce::jmax(1, (int)(feedbackNoteLengthMS * sampleRate / 1000));
 }
 
 void TimeAnalyzerAudioProcessor::releaseResources()
@@ -131,9 +142,159 @@ bool TimeAnalyzerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
 
 void TimeAnalyzerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    audioProcessCount++;
-    playHeadBpm = *getPlayHead()->getPosition()->getBpm();
-    playHeadTimeSignature = *getPlayHead()->getPosition()->getTimeSignature();
+    //the play head is only asked once per block
+    juce::Optional<juce::AudioPlayHead::PositionInfo> position;
+    if (getPlayHead() != nullptr)
+        position = getPlayHead()->getPosition();
+    m_transportState.update(position);
+    transportState.publish(m_transportState);
+
+    if (!liveInputEnabled)
+    {
+        //notes that were started before live input was turned off still end
+        writeMidiFeedback(midiMessages, buffer.getNumSamples());
+        return;
+    }
+
+    bool scoreChanged = false;
+    if (liveReference.update())
+    {
+        m_liveScore = LiveScore();
+        scoreChanged = true;
+    }
+    int numScored = m_liveScore.numHits;
+
+    //a hit is only placed on the timeline while the host is playing
+    if (!m_transportState.isPlaying || !m_transportState.hasPpqPosition)
+        m_liveHitDetector.reset();
+    else if (liveAudioEnabled)
+        detectLiveHits(buffer);
+    else
+        captureLiveNotes(midiMessages);
+
+    if (scoreChanged || m_liveScore.numHits != numScored)
+        liveScore.publish(m_liveScore);
+    //after the note-ons of the input were read
+    writeMidiFeedback(midiMessages, buffer.getNumSamples());
+}
+
+void TimeAnalyzerAudioProcessor::pushLiveHit(const LiveHit& hit, int samplePosition)
+{
+    liveHits.push(hit);
+    if (const LiveReference* reference = liveReference.get())
+        addMidiFeedback(reference->scoreHit(m_liveScore, hit.ppqPosition, hit.bpm, hit.note), samplePosition);
+}
+
+void TimeAnalyzerAudioProcessor::addMidiFeedback(const LiveReference::ScoredHit& scoredHit, int samplePosition)
+{
+    MidiFeedback feedback = midiFeedback;
+    if (feedback == MidiFeedback::off || !scoredHit.matched)
+        return;
+
+    if (feedback == MidiFeedback::controller)
+    {
+        if (m_numFeedbackEvents >= maxFeedbackEvents)
+            return;
+        m_numFeedbackEvents++;
+        int value = juce::jlimit(0, 127, 64 + juce::roundToInt(scoredHit.msDeviation));
+        m_midiFeedback.addEvent(juce::MidiMessage::controllerEvent(feedbackChannel, feedbackController, value), samplePosition);
+        return;
+    }
+
+    size_t note = scoredHit.onTime ? 1 : (scoredHit.msDeviation < 0 ? 0 : 2);
+    int numEvents = m_feedbackNoteOffs[note] >= 0 ? 2 : 1;
+    if (m_numFeedbackEvents + numEvents > maxFeedbackEvents)
+        return;
+    m_numFeedbackEvents += numEvents;
+    //a note that is still on is started again, a note that ran out earlier in the block still ends on time
+    if (m_feedbackNoteOffs[note] >= 0)
+        m_midiFeedback.addEvent(juce::MidiMessage::noteOff(feedbackChannel, feedbackNotes[note]), juce::jmin(m_feedbackNoteOffs[note], samplePosition));
+    m_midiFeedback.addEvent(juce::MidiMessage::noteOn(feedbackChannel, feedbackNotes[note], (juce::uint8)127), samplePosition);
+    m_feedbackNoteOffs[note] = samplePosition + m_feedbackNoteLength;
+}
+
+void TimeAnalyzerAudioProcessor::writeMidiFeedback(juce::MidiBuffer& midiMessages, int numSamples)
+{
+    for (size_t note = 0; note < m_feedbackNoteOffs.size(); note++)
+    {
+        int& noteOff = m_feedbackNoteOffs[note];
+        if (noteOff < 0)
+            continue;
+        if (noteOff < numSamples)
+        {
+            m_midiFeedback.addEvent(juce::MidiMessage::noteOff(feedbackChannel, feedbackNotes[note]), noteOff);
+            noteOff = -1;
+        }
+        else
+        {
+            noteOff -= numSamples;
+        }
+    }
+
+    //the input is passed through with the feedback merged in by sample
+    if (!m_midiFeedback.isEmpty())
+        midiMessages.addEvents(m_midiFeedback, 0, numSamples, 0);
+    m_midiFeedback.clear();
+    m_numFeedbackEvents = 0;
+}
+
+void TimeAnalyzerAudioProcessor::detectLiveHits(const juce::AudioBuffer<float>& buffer)
+{
+    if (liveDBThreshold != m_liveDBThreshold || liveHitDistanceMS != m_liveHitDistanceMS)
+    {
+        m_liveDBThreshold = liveDBThreshold;
+        m_liveHitDistanceMS = liveHitDistanceMS;
+        m_liveHitDetector.setThreshold(m_liveDBThreshold, m_liveHitDistanceMS);
+    }
+
+    int numInputChannels = juce::jmin(getTotalNumInputChannels(), buffer.getNumChannels(), (int)m_liveChannels.size());
+    if (numInputChannels <= 0)
+        return;
+
+    juce::int64 blockStart = m_liveHitDetector.getSamplePosition();
+    double bpm = m_transportState.bpm;
+    double blockPpq = m_transportState.ppqPosition;
+    juce::int64 blockTime = m_transportState.timeInSamples;
+    const float* const* inputChannels = buffer.getArrayOfReadPointers();
+    for (int sliceStart = 0; sliceStart < buffer.getNumSamples(); sliceStart += m_liveSliceLength)
+    {
+        int sliceLength = juce::jmin(m_liveSliceLength, buffer.getNumSamples() - sliceStart);
+        for (int channel = 0; channel < numInputChannels; channel++)
+            m_liveChannels[(size_t)channel] = inputChannels[channel] + sliceStart;
+
+        m_liveHitSamples.clearQuick();
+        m_liveHitDetector.process(m_liveChannels.data(), numInputChannels, sliceLength, m_liveHitSamples);
+        for (juce::int64 hitSample : m_liveHitSamples)
+        {
+            juce::int64 offset = hitSample - blockStart;
+            LiveHit hit;
+            hit.ppqPosition = blockPpq + offset / getSampleRate() * bpm / 60;
+            hit.bpm = bpm;
+            hit.timeInSamples = blockTime >= 0 ? blockTime + offset : -1;
+            pushLiveHit(hit, (int)juce::jlimit<juce::int64>(0, buffer.getNumSamples() - 1, offset));
+        }
+    }
+}
+
+void TimeAnalyzerAudioProcessor::captureLiveNotes(const juce::MidiBuffer& midiMessages)
+{
+    double bpm = m_transportState.bpm;
+    double blockPpq = m_transportState.ppqPosition;
+    juce::int64 blockTime = m_transportState.timeInSamples;
+    for (const juce::MidiMessageMetadata metadata : midiMessages)
+    {
+        const juce::MidiMessage& message = metadata.getMessage();
+        if (!message.isNoteOn())
+            continue;
+
+        LiveHit hit;
+        hit.ppqPosition = blockPpq + metadata.samplePosition / getSampleRate() * bpm / 60;
+        hit.bpm = bpm;
+        hit.timeInSamples = blockTime >= 0 ? blockTime + metadata.samplePosition : -1;
+        hit.note = message.getNoteNumber();
+        hit.velocity = message.getVelocity();
+        pushLiveHit(hit, metadata.samplePosition);
+    }
 }
 
 //==============================================================================
@@ -166,10 +327,51 @@ void TimeAnalyzerAudioProcessor::setStateInformation (const void* data, int size
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName(stateInfo.getType()))
             stateInfo = juce::ValueTree::fromXml(*xmlState);
+    loadLiveState();
     if (stateLoadedCallback)
         stateLoadedCallback();
 }
 
+TimeAnalyzerAudioProcessor::MidiFeedback TimeAnalyzerAudioProcessor::getMidiFeedback(int comboBoxId)
+{
+    if (comboBoxId == 2)
+        return MidiFeedback::controller;
+    if (comboBoxId == 3)
+        return MidiFeedback::notes;
+    return MidiFeedback::off;
+}
+
+void TimeAnalyzerAudioProcessor::loadLiveState()
+{
+    //the names are the ones the editor saves its components with
+    midiFeedback = getMidiFeedback(stateInfo.getProperty(NAME_OF(midiFeedback_ComboBox), 1));
+    liveAudioEnabled = (bool)stateInfo.getProperty(NAME_OF(analyzeAudioFiles_Toggle), false);
+    liveDBThreshold = (float)stateInfo.getProperty(NAME_OF(audioDBThreshold_Slider), 0);
+    liveHitDistanceMS = stateInfo.getProperty(NAME_OF(audioHitDistance_Editor), "50").toString().getIntValue();
+    liveInputEnabled = (bool)stateInfo.getProperty(NAME_OF(liveInput_Toggle), false);
+    if (!liveInputEnabled)
+        return;
+
+    juce::MidiFile quantizedMidiFile;
+    if (!AnalysisCore::getMidiFile(juce::File(stateInfo.getProperty(NAME_OF(m_quantizedMidiFile)).toString()), quantizedMidiFile))
+        return;
+
+    //the host tempo isn't known before the first block, the quantized notes are matched by their ticks
+    bool editTempo = stateInfo.getProperty(NAME_OF(editTempo_Toggle), false);
+    double bpm = editTempo ? stateInfo.getProperty(NAME_OF(tempo_Editor)).toString().getDoubleValue() : 120;
+    if (bpm <= 0)
+        bpm = 120;
+    vArray<MidiEvent> quantizedMidi;
+    AnalysisCore::readMidiFile(quantizedMidiFile, bpm, quantizedMidi);
+    auto tempoMap = std::make_shared<TempoMap>(TempoMap::fromMidiFile(quantizedMidiFile, bpm));
+
+    //the record start as the display of the editor placed it when the editor last built the reference
+    liveReference.set(std::make_unique<LiveReference>(quantizedMidi, MidiMatcher::parsePitchGroups(stateInfo.getProperty(NAME_OF(pitchGroups_Editor)).toString()),
+                                                      (double)stateInfo.getProperty(NAME_OF(m_liveReferenceRecordStart), 0),
+                                                      stateInfo.getProperty(NAME_OF(msTimeThreshold_Editor)).toString().getDoubleValue(),
+                                                      editTempo || !tempoMap->hasChanges() ? nullptr : tempoMap));
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
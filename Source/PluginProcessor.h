@@ -9,6 +9,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AudioDecoderService.h"
+#include "AudioHitDetector.h"
+#include "LockFree.h"
+#include "LiveScore.h"
+#include "TransportState.h"
 
 //==============================================================================
 /**
@@ -57,17 +62,98 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    double playHeadBpm;
-    juce::AudioPlayHead::TimeSignature playHeadTimeSignature;
-    int audioProcessCount = 0;
+    //the host position of the last block, published by the audio thread and read by the editor
+    TripleBuffer<TransportState> transportState;
 
     juce::ValueTree stateInfo{ "TimeAnalyzer" };
     juce::UndoManager undoManager;
     std::function<void()> stateLoadedCallback;
 
+    //shared by the polling and analysis of audio takes
+    AudioDecoderService audioDecoder{ AudioDecoderService::getDefaultScanThreads() };
+
+    //==============================================================================
+    //a hit of the audio input or a note-on of the midi input found in processBlock while the host is playing
+    struct LiveHit
+    {
+        //host position of the hit in quarter notes
+        double ppqPosition = 0;
+        double bpm = 120;
+        //host position in samples, -1 if the host doesn't give it
+        juce::int64 timeInSamples = -1;
+        //note of a midi note-on, -1 for a hit of the audio input
+        int note = -1;
+        juce::uint8 velocity = 0;
+    };
+
+    //live mode settings, written by the editor and read on the audio thread
+    std::atomic<bool> liveInputEnabled{ false };
+    //hits of the audio input instead of the note-ons of the midi input
+    std::atomic<bool> liveAudioEnabled{ false };
+    std::atomic<float> liveDBThreshold{ 0 };
+    std::atomic<int> liveHitDistanceMS{ 50 };
+    //pushed by the audio thread and popped by the editor
+    SpscQueue<LiveHit> liveHits{ 1024 };
+    //set by the editor, the live score starts over when the audio thread takes a new reference
+    RealtimeHandover<LiveReference> liveReference;
+    //the score of the live hits against liveReference, published by the audio thread after every block with hits
+    TripleBuffer<LiveScore> liveScore;
+
+    //timing of every matched live hit sent to the midi output in the block of the hit, e.g. for lights or a drum module
+    enum class MidiFeedback
+    {
+        off,
+        //feedbackController at 64 when the hit is exactly on time, one step per ms early (lower) or late (higher)
+        controller,
+        //a note of feedbackNoteLengthMS on the early, on time or late note of feedbackNotes
+        notes
+    };
+    std::atomic<MidiFeedback> midiFeedback{ MidiFeedback::off };
+    //of the items of midiFeedback_ComboBox
+    static MidiFeedback getMidiFeedback(int comboBoxId);
+    inline static const int feedbackChannel = 1;
+    inline static const int feedbackController = 20;
+    inline static const std::array<int, 3> feedbackNotes{ 60, 62, 64 };
+    inline static const int feedbackNoteLengthMS = 100;
+    //the hits of a block after these events get no feedback, so the midi buffers don't grow on the audio thread
+    inline static const int maxFeedbackEvents = 64;
+
+    //reads the live mode, its feedback and its reference from stateInfo so the live hits are scored and fed back while
+    //no editor is open. The editor replaces the reference when it opens
+    void loadLiveState();
+
     //==============================================================================
 
 private:
+    //runs the live hit detector on the input channels and pushes the hits, never allocates. A block longer than the
+    //one of prepareToPlay is detected in slices of that length
+    void detectLiveHits(const juce::AudioBuffer<float>& buffer);
+    //pushes every note-on of the block at its host position
+    void captureLiveNotes(const juce::MidiBuffer& midiMessages);
+    //queues the hit for the editor, adds it to the live score and its feedback at samplePosition of the block
+    void pushLiveHit(const LiveHit& hit, int samplePosition);
+    void addMidiFeedback(const LiveReference::ScoredHit& scoredHit, int samplePosition);
+    //ends the feedback notes that run out in this block and adds the feedback of the block to the midi output
+    void writeMidiFeedback(juce::MidiBuffer& midiMessages, int numSamples);
+
+    //only used on the audio thread
+    TransportState m_transportState;
+    AudioHitDetector m_liveHitDetector{ 44100, 0, 50 };
+    //a slice can't have more hits than samples, so the hits of a slice always fit in the storage of m_liveHitSamples
+    int m_liveSliceLength = 512;
+    juce::Array<juce::int64> m_liveHitSamples;
+    //the input channels from the start of the slice
+    std::vector<const float*> m_liveChannels;
+    float m_liveDBThreshold = 0;
+    int m_liveHitDistanceMS = 50;
+    LiveScore m_liveScore;
+    //preallocated in prepareToPlay for maxFeedbackEvents and the note offs, only holds the feedback of one block
+    juce::MidiBuffer m_midiFeedback;
+    int m_numFeedbackEvents = 0;
+    int m_feedbackNoteLength = 4410;
+    //samples from the start of the block until the note off of every feedback note, -1 when the note is off
+    std::array<int, 3> m_feedbackNoteOffs{ -1, -1, -1 };
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimeAnalyzerAudioProcessor)
 };
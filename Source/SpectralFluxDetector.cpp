@@ -0,0 +1,224 @@
+#include "SpectralFluxDetector.h"
+#include <algorithm>
+
+namespace
+{
+    const int numBins = SpectralFluxDetector::frameSize / 2 + 1;
+    //log(1 + compression * magnitude), so quiet partials still add to the flux
+    const float logCompression = 100.f;
+    //samples added to the interpolated frame position of an onset, measured at 48 kHz as the mean distance from the
+    //start of the decaying noise bursts of the benchmark to the frame whose flux peaks
+    const double onsetLatencySamples = -44;
+}
+
+//==============================================================================
+
+SpectralFluxDetector::SpectralFluxDetector(double sampleRate, float dBThreshold, int hitDistanceMS)
+    : m_sampleRate(sampleRate),
+    m_thresholdGain(std::pow(10.f, juce::jmax(dBThreshold, -100.f) * 0.05f)),
+    m_hitDistanceSamples(sampleRate * (hitDistanceMS / 1000.0)),
+    m_window(frameSize), m_input(frameSize), m_fftData(frameSize * 2), m_previousMagnitudes(numBins),
+    m_frames(medianFrames * 2 + 1), m_medianScratch(medianFrames * 2 + 1)
+{
+    //periodic hann, magnitudes are scaled so a full scale sine in the middle of a bin is 1
+    double windowSum = 0;
+    for (int i = 0; i < frameSize; i++)
+    {
+        m_window[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / frameSize);
+        windowSum += m_window[i];
+    }
+    juce::FloatVectorOperations::multiply(m_window.data(), (float)(2 / windowSum), frameSize);
+
+    reset();
+}
+
+void SpectralFluxDetector::reset()
+{
+    //the first frame ends with the first hop
+    std::fill(m_input.begin(), m_input.end(), 0.f);
+    m_inputSize = frameSize - hopSize;
+    std::fill(m_previousMagnitudes.begin(), m_previousMagnitudes.end(), 0.f);
+    std::fill(m_frames.begin(), m_frames.end(), Frame());
+    m_numFrames = 0;
+    m_numDecidedFrames = 0;
+    m_lastOnsetSample = -1;
+}
+
+void SpectralFluxDetector::process(const float* samples, int numSamples, juce::Array<double>& onsetSamples)
+{
+    while (numSamples > 0)
+    {
+        int numToCopy = juce::jmin(numSamples, frameSize - m_inputSize);
+        juce::FloatVectorOperations::copy(m_input.data() + m_inputSize, samples, numToCopy);
+        m_inputSize += numToCopy;
+        samples += numToCopy;
+        numSamples -= numToCopy;
+
+        if (m_inputSize < frameSize)
+            break;
+
+        processFrame();
+        if (m_numFrames > medianFrames)
+            decideFrame(onsetSamples);
+
+        std::copy(m_input.begin() + hopSize, m_input.end(), m_input.begin());
+        m_inputSize -= hopSize;
+    }
+}
+
+void SpectralFluxDetector::process(const float* const* channels, int numChannels, int numSamples, juce::Array<double>& onsetSamples)
+{
+    if (numChannels == 1)
+    {
+        process(channels[0], numSamples, onsetSamples);
+        return;
+    }
+
+    if ((int)m_mixedChannels.size() < numSamples)
+        m_mixedChannels.resize(numSamples);
+
+    juce::FloatVectorOperations::copy(m_mixedChannels.data(), channels[0], numSamples);
+    for (int channel = 1; channel < numChannels; channel++)
+        juce::FloatVectorOperations::add(m_mixedChannels.data(), channels[channel], numSamples);
+    juce::FloatVectorOperations::multiply(m_mixedChannels.data(), 1.f / numChannels, numSamples);
+    process(m_mixedChannels.data(), numSamples, onsetSamples);
+}
+
+void SpectralFluxDetector::finish(juce::Array<double>& onsetSamples)
+{
+    //silence pushes the last played frames through the median window
+    std::vector<float> silence((medianFrames + 2) * hopSize, 0.f);
+    process(silence.data(), (int)silence.size(), onsetSamples);
+}
+
+void SpectralFluxDetector::processFrame()
+{
+    Frame frame;
+    juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax(m_input.data(), frameSize);
+    frame.peak = juce::jmax(range.getEnd(), -range.getStart());
+
+    float* fftData = m_fftData.data();
+    juce::FloatVectorOperations::multiply(fftData, m_input.data(), m_window.data(), frameSize);
+    juce::FloatVectorOperations::clear(fftData + frameSize, frameSize);
+    m_fft.performFrequencyOnlyForwardTransform(fftData, true);
+
+    float flux = 0;
+    for (int bin = 0; bin < numBins; bin++)
+    {
+        float magnitude = std::log1p(logCompression * fftData[bin]);
+        flux += juce::jmax(0.f, magnitude - m_previousMagnitudes[bin]);
+        m_previousMagnitudes[bin] = magnitude;
+    }
+    frame.flux = flux / numBins;
+
+    m_frames[m_numFrames % m_frames.size()] = frame;
+    m_numFrames++;
+}
+
+void SpectralFluxDetector::decideFrame(juce::Array<double>& onsetSamples)
+{
+    juce::int64 frameIndex = m_numDecidedFrames++;
+    auto getFrame = [this](juce::int64 index) -> const Frame& { return m_frames[index % m_frames.size()]; };
+    const Frame& frame = getFrame(frameIndex);
+    if (frame.peak <= m_thresholdGain || frame.flux <= minimumFlux)
+        return;
+
+    //a peak of the two frames on either side, the first frame of a plateau wins
+    juce::int64 firstFrame = juce::jmax<juce::int64>(0, frameIndex - medianFrames);
+    juce::int64 lastFrame = frameIndex + medianFrames;
+    for (juce::int64 i = juce::jmax(firstFrame, frameIndex - 2); i <= frameIndex + 2; i++)
+    {
+        if (i < frameIndex ? getFrame(i).flux >= frame.flux : getFrame(i).flux > frame.flux)
+            return;
+    }
+
+    int numWindowFrames = 0;
+    for (juce::int64 i = firstFrame; i <= lastFrame; i++)
+        m_medianScratch[numWindowFrames++] = getFrame(i).flux;
+    auto median = m_medianScratch.begin() + numWindowFrames / 2;
+    std::nth_element(m_medianScratch.begin(), median, m_medianScratch.begin() + numWindowFrames);
+    if (frame.flux <= medianMultiplier * *median + minimumFlux)
+        return;
+
+    //vertex of the parabola through the peak and its neighbours
+    double offset = 0;
+    if (frameIndex > 0)
+    {
+        float previous = getFrame(frameIndex - 1).flux;
+        float next = getFrame(frameIndex + 1).flux;
+        float curvature = previous - 2 * frame.flux + next;
+        if (curvature < 0)
+            offset = juce::jlimit(-0.5, 0.5, 0.5 * (previous - next) / curvature);
+    }
+
+    double onsetSample = juce::jmax(0.0, (frameIndex + offset) * hopSize + onsetLatencySamples);
+    if (m_lastOnsetSample >= 0 && onsetSample - m_lastOnsetSample <= m_hitDistanceSamples)
+        return;
+
+    onsetSamples.add(onsetSample);
+    m_lastOnsetSample = onsetSample;
+}
+
+//==============================================================================
+
+BenchmarkResult SpectralFluxDetector::benchmark(int numSeconds)
+{
+    double sampleRate = 48000;
+    int numSamples = (int)(numSeconds * sampleRate);
+    juce::Random random(numSeconds);
+
+    //noise bursts of 20 to 400 ms decay every 100 to 400 ms over quiet noise, the bursts are kept to check the onsets.
+    //A burst is at least two hops long, a shorter one can fall between frames
+    std::vector<float> samples(numSamples);
+    BenchmarkHits bursts;
+    bursts.sampleRate = sampleRate;
+    bursts.firstHit = (juce::int64)(sampleRate * 0.1);
+    bursts.minGain = 0.05f;
+    bursts.maxGain = 0.95f;
+    bursts.minDecaySeconds = 0.02;
+    bursts.maxDecaySeconds = 0.4;
+    std::vector<BenchmarkHits::Hit> burstHits = bursts.generate(samples.data(), numSamples, random);
+
+    double startMS = juce::Time::getMillisecondCounterHiRes();
+    SpectralFluxDetector detector(sampleRate, -40, 50);
+    juce::Array<double> onsets;
+    for (int start = 0; start < numSamples; start += 1 << 16)
+        detector.process(samples.data() + start, juce::jmin(1 << 16, numSamples - start), onsets);
+    detector.finish(onsets);
+    double seconds = (juce::Time::getMillisecondCounterHiRes() - startMS) / 1000;
+
+    //every burst should have one onset within 10 ms, except a burst that is less than 12 dB above the decay it starts on.
+    //The flux of noise on noise varies so much that a smaller step is often under the median threshold
+    int numBuried = 0;
+    int found = 0;
+    double sumError = 0;
+    double maxError = 0;
+    int onsetIndex = 0;
+    for (const BenchmarkHits::Hit& burstHit : burstHits)
+    {
+        if (burstHit.gain < 4 * burstHit.gainBefore)
+        {
+            numBuried++;
+            continue;
+        }
+
+        double burst = (double)burstHit.sample;
+        while (onsetIndex < onsets.size() && onsets[onsetIndex] < burst - sampleRate * 0.01)
+            onsetIndex++;
+        if (onsetIndex < onsets.size() && onsets[onsetIndex] <= burst + sampleRate * 0.01)
+        {
+            double error = (onsets[onsetIndex] - burst) / sampleRate * 1000;
+            sumError += error;
+            maxError = juce::jmax(maxError, std::abs(error));
+            found++;
+        }
+    }
+
+    juce::String output = "SpectralFluxDetector::benchmark " + juce::String(numSeconds) + " s of random noise bursts\n";
+    output += "time: " + juce::String(seconds * 1000, 1) + " ms, " + juce::String(numSeconds / juce::jmax(seconds, 1e-9), 0) + "x real time\n";
+    int numAudible = (int)burstHits.size() - numBuried;
+    output += "bursts: " + juce::String((int)burstHits.size()) + ", buried in the decay before: " + juce::String(numBuried)
+              + ", onsets: " + juce::String(onsets.size()) + ", found: " + juce::String(found) + "/" + juce::String(numAudible) + "\n";
+    output += "mean error: " + juce::String(found > 0 ? sumError / found : 0, 2) + " ms, max error: " + juce::String(maxError, 2) + " ms\n";
+    return { output, numAudible - found };
+}
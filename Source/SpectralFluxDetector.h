@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Globals.h"
+#include <vector>
+
+//==============================================================================
+//onset detector on the spectral flux of overlapping hann windowed frames, the summed increase of the log magnitude
+//of every bin from the previous frame. A frame is an onset when its flux is a local peak above the median of the
+//frames around it, so the decay of a cymbal that rises the median doesn't trigger again while a ghost note over
+//a quiet passage still does. The time of an onset is interpolated between frames from the parabola through its peak.
+//
+//Audio is passed in one block at a time, onsets are reported medianFrames frames after they were played
+class SpectralFluxDetector
+{
+public:
+    //dBThreshold gates frames that are quieter than it, hitDistanceMS is the least distance between onsets
+    SpectralFluxDetector(double sampleRate, float dBThreshold, int hitDistanceMS);
+
+    void reset();
+
+    //adds the absolute sample position of every onset that can be decided with the blocks passed so far
+    void process(const float* samples, int numSamples, juce::Array<double>& onsetSamples);
+    //the mix of the channels
+    void process(const float* const* channels, int numChannels, int numSamples, juce::Array<double>& onsetSamples);
+    //decides the last frames, call after the last block
+    void finish(juce::Array<double>& onsetSamples);
+
+    //frames per second of audio at the sample rate
+    double getFrameRate() const { return m_sampleRate / hopSize; }
+
+    inline static const int fftOrder = 9;
+    inline static const int frameSize = 1 << fftOrder;
+    inline static const int hopSize = frameSize / 2;
+    //frames before and after a frame that its threshold is the median of
+    inline static const int medianFrames = 5;
+    //the threshold is medianMultiplier times the median plus minimumFlux
+    inline static constexpr float medianMultiplier = 1.5f;
+    inline static constexpr float minimumFlux = 0.02f;
+
+    //times the detector on random drum like audio and reports the throughput, every burst that stands out of the
+    //decay before it and has no onset within 10 ms fails
+    static BenchmarkResult benchmark(int numSeconds);
+
+private:
+    struct Frame
+    {
+        float flux = 0;
+        //peak absolute sample of the whole frame, not only of the hop that the frame added
+        float peak = 0;
+    };
+
+    void processFrame();
+    //decides the frame medianFrames before the newest one
+    void decideFrame(juce::Array<double>& onsetSamples);
+
+    double m_sampleRate;
+    float m_thresholdGain;
+    double m_hitDistanceSamples;
+
+    juce::dsp::FFT m_fft{ fftOrder };
+    std::vector<float> m_window;
+    //the newest frameSize samples
+    std::vector<float> m_input;
+    int m_inputSize = 0;
+    std::vector<float> m_fftData;
+    std::vector<float> m_previousMagnitudes;
+    std::vector<float> m_mixedChannels;
+
+    //the last 2 * medianFrames + 1 frames, m_frames[m_numFrames % size] is the oldest
+    std::vector<Frame> m_frames;
+    std::vector<float> m_medianScratch;
+    juce::int64 m_numFrames = 0;
+    juce::int64 m_numDecidedFrames = 0;
+    double m_lastOnsetSample = -1;
+
+private:
+    JUCE_LEAK_DETECTOR(SpectralFluxDetector)
+};
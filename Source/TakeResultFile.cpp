@@ -0,0 +1,358 @@
+#include "TakeResultFile.h"
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    enum HeaderFlags
+    {
+        oneToOneAlignmentFlag = 1 << 0,
+        audioTakeFlag = 1 << 1,
+        audioPerChannelFlag = 1 << 2,
+        spectralFluxFlag = 1 << 3
+    };
+
+    juce::int64 toFixedPoint(double tick) { return (juce::int64)std::llround(tick * TakeResultFile::tickResolution); }
+
+    juce::uint64 zigzagEncode(juce::int64 value) { return ((juce::uint64)value << 1) ^ (juce::uint64)(value >> 63); }
+    juce::int64 zigzagDecode(juce::uint64 value) { return (juce::int64)(value >> 1) ^ -(juce::int64)(value & 1); }
+
+    void writeUnsignedVarint(juce::MemoryOutputStream& out, juce::uint64 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.writeByte((char)value);
+    }
+
+    bool readUnsignedVarint(const juce::uint8*& data, const juce::uint8* end, juce::uint64& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && data < end; shift += 7)
+        {
+            juce::uint8 byte = *data++;
+            value |= (juce::uint64)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+//==============================================================================
+
+void TakeResultFile::writeVarint(juce::MemoryOutputStream& out, juce::int64 value)
+{
+    writeUnsignedVarint(out, zigzagEncode(value));
+}
+
+bool TakeResultFile::readVarint(const juce::uint8*& data, const juce::uint8* end, juce::int64& value)
+{
+    juce::uint64 encoded;
+    if (!readUnsignedVarint(data, end, encoded))
+        return false;
+    value = zigzagDecode(encoded);
+    return true;
+}
+
+bool TakeResultFile::write(const juce::File& resultFile, const TakeResult& result, const vArray<MidiEvent>& quantizedMidi,
+                           const AnalysisSettings& settings, juce::String& error)
+{
+    const vArray<MidiEvent>& hits = result.analyzedMidi;
+
+    juce::MemoryOutputStream tickStarts, tickLengths, indices, deviations, notes;
+    juce::int64 previousTick = 0;
+    int previousIndex = 0;
+    for (const MidiEvent& midi : hits)
+    {
+        juce::int64 tick = toFixedPoint(midi.tickStart);
+        writeVarint(tickStarts, tick - previousTick);
+        previousTick = tick;
+        writeVarint(tickLengths, toFixedPoint(midi.tickEnd) - tick);
+
+        float deviation = std::numeric_limits<float>::quiet_NaN();
+        if (midi.closestQuantizedIndex >= 0 && midi.closestQuantizedIndex < quantizedMidi.size())
+        {
+            //0 is an unmatched hit so the matched deltas are shifted by one
+            writeUnsignedVarint(indices, zigzagEncode(midi.closestQuantizedIndex - previousIndex) + 1);
+            previousIndex = midi.closestQuantizedIndex;
+            deviation = (float)AnalysisCore::getMSDeviation(midi, quantizedMidi.getReference(midi.closestQuantizedIndex),
+                                                            settings.recordBeatStart, settings.bpm, settings.tempoMap.get());
+        }
+        else
+        {
+            writeUnsignedVarint(indices, 0);
+        }
+        deviations.writeFloat(deviation);
+        notes.writeByte((char)((midi.note & 0x7f) | (midi.useQuantizedNote ? 0x80 : 0)));
+    }
+
+    //the deviation column is aligned to 4 bytes
+    juce::uint32 tickStartOffset = headerSize;
+    juce::uint32 tickLengthOffset = tickStartOffset + (juce::uint32)tickStarts.getDataSize();
+    juce::uint32 indexOffset = tickLengthOffset + (juce::uint32)tickLengths.getDataSize();
+    juce::uint32 deviationOffset = (juce::uint32)((indexOffset + indices.getDataSize() + 3) & ~(size_t)3);
+    juce::uint32 noteOffset = deviationOffset + (juce::uint32)deviations.getDataSize();
+    juce::uint32 totalSize = noteOffset + (juce::uint32)notes.getDataSize();
+
+    juce::uint32 flags = 0;
+    if (settings.oneToOneAlignment)
+        flags |= oneToOneAlignmentFlag;
+    if (AnalysisCore::isAudioFile(result.take))
+        flags |= audioTakeFlag;
+    if (settings.audioPerChannel)
+        flags |= audioPerChannelFlag;
+    if (settings.audioDetector == AnalysisSettings::AudioDetector::spectralFlux)
+        flags |= spectralFluxFlag;
+
+    juce::MemoryOutputStream out;
+    out.preallocate(totalSize);
+    out.writeInt((int)magic);
+    out.writeInt((int)version);
+    out.writeInt(hits.size());
+    out.writeInt(hits.isEmpty() ? (int)g_defaultQuarterNoteTicks : hits.getFirst().quarterNoteTicks);
+    out.writeInt(result.numMissed);
+    out.writeInt(result.numExtra);
+    out.writeInt64(result.take.getSize());
+    out.writeInt64(result.take.getLastModificationTime().toMilliseconds());
+    out.writeDouble(settings.bpm);
+    out.writeDouble(settings.recordBeatStart);
+    out.writeDouble(settings.msTimeThreshold);
+    out.writeDouble(settings.msAlignmentWindow);
+    out.writeFloat(settings.audioDBThreshold);
+    out.writeInt(settings.audioHitDistanceMS);
+    out.writeInt((int)flags);
+    out.writeInt(settings.timeSignatureNumerator);
+    for (juce::uint32 offset : { tickStartOffset, tickLengthOffset, indexOffset, deviationOffset, noteOffset, totalSize })
+        out.writeInt((int)offset);
+    out.writeInt((int)getTempoMapHash(settings));
+    jassert(out.getDataSize() == headerSize);
+
+    out << tickStarts.getMemoryBlock() << tickLengths.getMemoryBlock() << indices.getMemoryBlock();
+    while (out.getDataSize() < deviationOffset)
+        out.writeByte(0);
+    out << deviations.getMemoryBlock() << notes.getMemoryBlock();
+
+    //written next to the result file and moved over it so an open memory map never sees half a file
+    juce::TemporaryFile temporaryFile(resultFile);
+    if (!temporaryFile.getFile().replaceWithData(out.getData(), out.getDataSize()) || !temporaryFile.overwriteTargetFileWithTemporary())
+    {
+        error = "Can't write " + resultFile.getFileName();
+        return false;
+    }
+    return true;
+}
+
+TakeResult TakeResultFile::analyzeTake(AudioDecoderService& decoder, const juce::File& take, const vArray<MidiEvent>& quantizedMidi,
+                                       const MidiMatcher& matcher, const AnalysisSettings& settings, const ShouldCancel& shouldCancel)
+{
+    juce::File resultFile = getResultFile(take);
+    TakeResultFile takeResultFile;
+    if (takeResultFile.open(resultFile) && takeResultFile.isUpToDate(take) && takeResultFile.wasReadWith(settings))
+    {
+        TakeResult result;
+        result.take = take;
+        if (takeResultFile.readAnalyzedMidi(result.analyzedMidi))
+        {
+            AnalysisCore::scoreTake(result, quantizedMidi, matcher, settings);
+
+            //the hits are the same but they were scored with other settings
+            AnalysisSettings written = takeResultFile.getSettings();
+            juce::uint32 writtenTempoMapHash = takeResultFile.getTempoMapHash();
+            takeResultFile.close();
+            if (written.recordBeatStart != settings.recordBeatStart || written.msTimeThreshold != settings.msTimeThreshold
+                || written.oneToOneAlignment != settings.oneToOneAlignment || written.msAlignmentWindow != settings.msAlignmentWindow
+                || written.timeSignatureNumerator != settings.timeSignatureNumerator
+                || writtenTempoMapHash != getTempoMapHash(settings))
+            {
+                juce::String writeError;
+                write(resultFile, result, quantizedMidi, settings, writeError);
+            }
+            return result;
+        }
+    }
+    takeResultFile.close();
+
+    TakeResult result = AnalysisCore::analyzeTake(decoder, take, quantizedMidi, matcher, settings, shouldCancel);
+    juce::String writeError;
+    if (result.wasAnalyzed())
+        write(resultFile, result, quantizedMidi, settings, writeError);
+    return result;
+}
+
+//==============================================================================
+
+bool TakeResultFile::open(const juce::File& resultFile)
+{
+    close();
+    if (!resultFile.existsAsFile())
+        return false;
+
+    m_mappedFile = std::make_unique<juce::MemoryMappedFile>(resultFile, juce::MemoryMappedFile::readOnly);
+    const juce::uint8* data = (const juce::uint8*)m_mappedFile->getData();
+    size_t size = m_mappedFile->getSize();
+    if (data == nullptr || size < (size_t)headerSize)
+    {
+        close();
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_numHits = (int)readUInt32(8);
+    m_tickStartOffset = readUInt32(88);
+    m_tickLengthOffset = readUInt32(92);
+    m_indexOffset = readUInt32(96);
+    m_deviationOffset = readUInt32(100);
+    m_noteOffset = readUInt32(104);
+    juce::uint32 totalSize = readUInt32(108);
+
+    bool isValid = readUInt32(0) == magic && readUInt32(4) == version && totalSize == size
+                   && m_tickStartOffset <= m_tickLengthOffset && m_tickLengthOffset <= m_indexOffset && m_indexOffset <= m_deviationOffset
+                   && m_deviationOffset % 4 == 0 && m_deviationOffset + (juce::uint64)m_numHits * 4 == m_noteOffset
+                   && m_noteOffset + (juce::uint64)m_numHits == totalSize;
+    if (!isValid)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TakeResultFile::close()
+{
+    m_mappedFile = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_numHits = 0;
+}
+
+bool TakeResultFile::isUpToDate(const juce::File& take) const
+{
+    return isOpen() && take.getSize() == readInt64(24) && take.getLastModificationTime().toMilliseconds() == readInt64(32);
+}
+
+bool TakeResultFile::wasReadWith(const AnalysisSettings& settings) const
+{
+    if (!isOpen())
+        return false;
+
+    AnalysisSettings written = getSettings();
+    if (written.bpm != settings.bpm)
+        return false;
+    //the ms of audio hits are placed on the tempo map from the record start
+    if ((readUInt32(80) & audioTakeFlag) != 0)
+        return written.audioDBThreshold == settings.audioDBThreshold && written.audioHitDistanceMS == settings.audioHitDistanceMS
+               && written.audioPerChannel == settings.audioPerChannel && written.audioDetector == settings.audioDetector
+               && getTempoMapHash() == getTempoMapHash(settings) && (getTempoMapHash() == 0 || written.recordBeatStart == settings.recordBeatStart);
+    return true;
+}
+
+int TakeResultFile::getNumMissed() const
+{
+    return isOpen() ? (int)readUInt32(16) : 0;
+}
+
+int TakeResultFile::getNumExtra() const
+{
+    return isOpen() ? (int)readUInt32(20) : 0;
+}
+
+AnalysisSettings TakeResultFile::getSettings() const
+{
+    AnalysisSettings settings;
+    if (!isOpen())
+        return settings;
+
+    settings.bpm = readDouble(40);
+    settings.recordBeatStart = readDouble(48);
+    settings.msTimeThreshold = readDouble(56);
+    settings.msAlignmentWindow = readDouble(64);
+    juce::uint32 dBThresholdBits = readUInt32(72);
+    std::memcpy(&settings.audioDBThreshold, &dBThresholdBits, sizeof(float));
+    settings.audioHitDistanceMS = (int)readUInt32(76);
+    settings.oneToOneAlignment = (readUInt32(80) & oneToOneAlignmentFlag) != 0;
+    settings.audioPerChannel = (readUInt32(80) & audioPerChannelFlag) != 0;
+    settings.audioDetector = (readUInt32(80) & spectralFluxFlag) != 0 ? AnalysisSettings::AudioDetector::spectralFlux
+                                                                      : AnalysisSettings::AudioDetector::amplitude;
+    settings.timeSignatureNumerator = (int)readUInt32(84);
+    return settings;
+}
+
+double TakeResultFile::readDouble(int offset) const
+{
+    juce::uint64 bits = juce::ByteOrder::littleEndianInt64(m_data + offset);
+    double value;
+    std::memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+float TakeResultFile::getDeviation(int hit) const
+{
+    juce::uint32 bits = juce::ByteOrder::littleEndianInt(m_data + m_deviationOffset + hit * 4);
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+TimingSummary TakeResultFile::getSummary() const
+{
+    TimingSummary summary;
+    double msTimeThreshold = isOpen() ? readDouble(56) : 0;
+    for (int i = 0; i < m_numHits; i++)
+    {
+        float deviation = getDeviation(i);
+        if (!std::isnan(deviation))
+            summary.add(deviation, std::abs(deviation) <= msTimeThreshold);
+    }
+    return summary;
+}
+
+bool TakeResultFile::readAnalyzedMidi(vArray<MidiEvent>& out) const
+{
+    if (!isOpen())
+        return false;
+
+    int quarterNoteTicks = (int)readUInt32(12);
+    double bpm = readDouble(40);
+
+    const juce::uint8* tickStarts = m_data + m_tickStartOffset;
+    const juce::uint8* tickLengths = m_data + m_tickLengthOffset;
+    const juce::uint8* indices = m_data + m_indexOffset;
+
+    out.clear();
+    out.ensureStorageAllocated(m_numHits);
+    juce::int64 tick = 0;
+    int previousIndex = 0;
+    for (int i = 0; i < m_numHits; i++)
+    {
+        juce::int64 tickDelta, tickLength;
+        juce::uint64 index;
+        if (!readVarint(tickStarts, m_data + m_tickLengthOffset, tickDelta)
+            || !readVarint(tickLengths, m_data + m_indexOffset, tickLength)
+            || !readUnsignedVarint(indices, m_data + m_deviationOffset, index))
+        {
+            out.clear();
+            return false;
+        }
+        tick += tickDelta;
+
+        MidiEvent midi;
+        juce::uint8 note = m_data[m_noteOffset + i];
+        midi.note = note & 0x7f;
+        midi.useQuantizedNote = (note & 0x80) != 0;
+        midi.quarterNoteTicks = quarterNoteTicks;
+        midi.tickStart = (double)tick / tickResolution;
+        midi.tickEnd = (double)(tick + tickLength) / tickResolution;
+        midi.debugMS = MidiEvent::getMiliseconds(midi.tickStart, bpm, quarterNoteTicks);
+        if (index != 0)
+        {
+            previousIndex += (int)zigzagDecode(index - 1);
+            midi.closestQuantizedIndex = previousIndex;
+        }
+        out.add(midi);
+    }
+    return true;
+}
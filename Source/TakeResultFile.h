@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AnalysisCore.h"
+
+//==============================================================================
+//binary sidecar of an analyzed take, "take.mid" gets "take.mid.tares" next to it.
+//
+//A fixed header followed by one column per field so a column can be read without decoding the others:
+//  tick start     zigzag varint of the delta to the previous hit, fixed point with tickResolution steps per tick
+//  tick length    zigzag varint, fixed point
+//  matched index  zigzag varint of the delta to the previous matched index, -1 when the hit isn't matched
+//  deviation      float32 ms, positive when late, NaN when the hit isn't matched
+//  note           uint8, the high bit is set for hits that use the quantized note (audio hits)
+//
+//Version 2 added the hash of the tempo map at the end of the header, 0 for a constant bpm
+//
+//Everything is little endian. The file is opened with a memory map so the header and the fixed size columns
+//are available without reading the file, only the varint columns are decoded when the hits are needed
+class TakeResultFile
+{
+public:
+    TakeResultFile() {}
+
+    static juce::File getResultFile(const juce::File& take) { return take.getSiblingFile(take.getFileName() + fileExtension); }
+
+    //deviations are taken from quantizedMidi, the analyzed midi of the result has to be matched already
+    static bool write(const juce::File& resultFile, const TakeResult& result, const vArray<MidiEvent>& quantizedMidi,
+                      const AnalysisSettings& settings, juce::String& error);
+
+    //uses the result file of the take if it was written for the same take and read settings,
+    //otherwise analyzes the take and writes the result file
+    static TakeResult analyzeTake(AudioDecoderService& decoder, const juce::File& take, const vArray<MidiEvent>& quantizedMidi,
+                                  const MidiMatcher& matcher, const AnalysisSettings& settings, const ShouldCancel& shouldCancel = nullptr);
+
+    //==============================================================================
+    bool open(const juce::File& resultFile);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    //the take was not changed since the result file was written
+    bool isUpToDate(const juce::File& take) const;
+    //the analyzed midi would be the same when the take is read with these settings
+    bool wasReadWith(const AnalysisSettings& settings) const;
+
+    int getNumHits() const { return m_numHits; }
+    int getNumMissed() const;
+    int getNumExtra() const;
+    AnalysisSettings getSettings() const;
+    //TempoMap::getHash of the map the take was read and scored with, 0 without one
+    juce::uint32 getTempoMapHash() const { return isOpen() ? readUInt32(112) : 0; }
+    static juce::uint32 getTempoMapHash(const AnalysisSettings& settings) { return settings.tempoMap != nullptr ? settings.tempoMap->getHash() : 0; }
+
+    float getDeviation(int hit) const;
+    int getNote(int hit) const { return m_data[m_noteOffset + hit] & 0x7f; }
+
+    //timing of the matched hits from the deviation column, without measures or pitches of the reference
+    TimingSummary getSummary() const;
+    //decodes the hits with their closestQuantizedIndex
+    bool readAnalyzedMidi(vArray<MidiEvent>& out) const;
+
+    //==============================================================================
+    inline static const juce::String fileExtension = ".tares";
+    inline static const juce::uint32 magic = 0x53524154; //"TARS"
+    inline static const juce::uint32 version = 2;
+    inline static const int tickResolution = 16;
+    inline static const int headerSize = 116;
+
+    static void writeVarint(juce::MemoryOutputStream& out, juce::int64 value);
+    //returns false if the varint runs past end
+    static bool readVarint(const juce::uint8*& data, const juce::uint8* end, juce::int64& value);
+
+private:
+    juce::uint32 readUInt32(int offset) const { return juce::ByteOrder::littleEndianInt(m_data + offset); }
+    juce::int64 readInt64(int offset) const { return (juce::int64)juce::ByteOrder::littleEndianInt64(m_data + offset); }
+    double readDouble(int offset) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> m_mappedFile;
+    const juce::uint8* m_data = nullptr;
+    size_t m_size = 0;
+    int m_numHits = 0;
+    juce::uint32 m_tickStartOffset = 0;
+    juce::uint32 m_tickLengthOffset = 0;
+    juce::uint32 m_indexOffset = 0;
+    juce::uint32 m_deviationOffset = 0;
+    juce::uint32 m_noteOffset = 0;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeResultFile)
+};
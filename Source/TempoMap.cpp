@@ -0,0 +1,265 @@
+#include "TempoMap.h"
+#include <algorithm>
+#include <cstring>
+
+//==============================================================================
+
+TempoMap::TempoMap(double bpm, int numerator, int denominator)
+{
+    addTempoChange(0, bpm);
+    addMeterChange(0, numerator, denominator);
+}
+
+TempoMap TempoMap::fromMidiFile(const juce::MidiFile& midiFile, double bpm)
+{
+    TempoMap tempoMap(bpm);
+    //only ticks per quarter note, smpte time stamps have no tempo
+    int quarterNoteTicks = midiFile.getTimeFormat();
+    if (quarterNoteTicks <= 0)
+        return tempoMap;
+
+    juce::MidiMessageSequence tempoEvents;
+    midiFile.findAllTempoEvents(tempoEvents);
+    for (auto event : tempoEvents)
+    {
+        double secondsPerQuarterNote = event->message.getTempoSecondsPerQuarterNote();
+        if (secondsPerQuarterNote > 0)
+            tempoMap.addTempoChange(event->message.getTimeStamp() * g_defaultQuarterNoteTicks / quarterNoteTicks, 60 / secondsPerQuarterNote);
+    }
+
+    juce::MidiMessageSequence timeSignatureEvents;
+    midiFile.findAllTimeSigEvents(timeSignatureEvents);
+    for (auto event : timeSignatureEvents)
+    {
+        int numerator = 4;
+        int denominator = 4;
+        event->message.getTimeSignatureInfo(numerator, denominator);
+        tempoMap.addMeterChange(event->message.getTimeStamp() * g_defaultQuarterNoteTicks / quarterNoteTicks, numerator, denominator);
+    }
+    return tempoMap;
+}
+
+void TempoMap::addTempoChange(double tick, double bpm)
+{
+    if (bpm <= 0)
+        return;
+
+    TempoSegment segment;
+    segment.tick = juce::jmax(0.0, tick);
+    segment.bpm = bpm;
+    auto position = std::lower_bound(m_tempos.begin(), m_tempos.end(), segment.tick,
+                                     [](const TempoSegment& a, double b) { return a.tick < b; });
+    size_t index = (size_t)(position - m_tempos.begin());
+    if (position != m_tempos.end() && position->tick == segment.tick)
+        *position = segment;
+    else
+        m_tempos.insert(position, segment);
+    updateTempoSegments(index);
+}
+
+void TempoMap::addMeterChange(double tick, int numerator, int denominator)
+{
+    if (numerator <= 0 || denominator <= 0)
+        return;
+
+    MeterSegment segment;
+    segment.tick = juce::jmax(0.0, tick);
+    segment.numerator = numerator;
+    segment.denominator = denominator;
+    auto position = std::lower_bound(m_meters.begin(), m_meters.end(), segment.tick,
+                                     [](const MeterSegment& a, double b) { return a.tick < b; });
+    size_t index = (size_t)(position - m_meters.begin());
+    if (position != m_meters.end() && position->tick == segment.tick)
+        *position = segment;
+    else
+        m_meters.insert(position, segment);
+    updateMeterSegments(index);
+}
+
+void TempoMap::updateTempoSegments(size_t first)
+{
+    for (size_t i = first; i < m_tempos.size(); i++)
+    {
+        TempoSegment& segment = m_tempos[i];
+        segment.msPerTick = 60000 / (segment.bpm * g_defaultQuarterNoteTicks);
+        segment.ms = i == 0 ? segment.tick * segment.msPerTick
+                            : m_tempos[i - 1].ms + (segment.tick - m_tempos[i - 1].tick) * m_tempos[i - 1].msPerTick;
+    }
+}
+
+void TempoMap::updateMeterSegments(size_t first)
+{
+    for (size_t i = first; i < m_meters.size(); i++)
+    {
+        MeterSegment& segment = m_meters[i];
+        segment.ticksPerMeasure = segment.numerator * g_defaultQuarterNoteTicks * 4 / segment.denominator;
+        segment.measure = i == 0 ? segment.tick / segment.ticksPerMeasure
+                                 : m_meters[i - 1].measure + (segment.tick - m_meters[i - 1].tick) / m_meters[i - 1].ticksPerMeasure;
+    }
+}
+
+template <typename Segment, typename Value>
+int TempoMap::findSegment(const std::vector<Segment>& segments, Value Segment::* key, double value)
+{
+    auto after = std::upper_bound(segments.begin(), segments.end(), value,
+                                  [key](double a, const Segment& b) { return a < b.*key; });
+    return juce::jmax(0, (int)(after - segments.begin()) - 1);
+}
+
+//==============================================================================
+
+double TempoMap::getBpm(double tick) const
+{
+    return m_tempos[(size_t)findSegment(m_tempos, &TempoSegment::tick, tick)].bpm;
+}
+
+juce::AudioPlayHead::TimeSignature TempoMap::getTimeSignature(double tick) const
+{
+    const MeterSegment& segment = m_meters[(size_t)findSegment(m_meters, &MeterSegment::tick, tick)];
+    juce::AudioPlayHead::TimeSignature timeSignature;
+    timeSignature.numerator = segment.numerator;
+    timeSignature.denominator = segment.denominator;
+    return timeSignature;
+}
+
+double TempoMap::tickToMS(double tick) const
+{
+    const TempoSegment& segment = m_tempos[(size_t)findSegment(m_tempos, &TempoSegment::tick, tick)];
+    return segment.ms + (tick - segment.tick) * segment.msPerTick;
+}
+
+double TempoMap::msToTick(double ms) const
+{
+    const TempoSegment& segment = m_tempos[(size_t)findSegment(m_tempos, &TempoSegment::ms, ms)];
+    return segment.tick + (ms - segment.ms) / segment.msPerTick;
+}
+
+void TempoMap::ticksToMS(const double* ticks, double* ms, int numValues) const
+{
+    size_t segment = 0;
+    for (int i = 0; i < numValues; i++)
+    {
+        double tick = ticks[i];
+        while (segment + 1 < m_tempos.size() && m_tempos[segment + 1].tick <= tick)
+            segment++;
+        ms[i] = m_tempos[segment].ms + (tick - m_tempos[segment].tick) * m_tempos[segment].msPerTick;
+    }
+}
+
+void TempoMap::msToTicks(const double* ms, double* ticks, int numValues) const
+{
+    size_t segment = 0;
+    for (int i = 0; i < numValues; i++)
+    {
+        double value = ms[i];
+        while (segment + 1 < m_tempos.size() && m_tempos[segment + 1].ms <= value)
+            segment++;
+        ticks[i] = m_tempos[segment].tick + (value - m_tempos[segment].ms) / m_tempos[segment].msPerTick;
+    }
+}
+
+double TempoMap::tickToMeasure(double tick) const
+{
+    const MeterSegment& segment = m_meters[(size_t)findSegment(m_meters, &MeterSegment::tick, tick)];
+    return segment.measure + (tick - segment.tick) / segment.ticksPerMeasure;
+}
+
+double TempoMap::measureToTick(double measure) const
+{
+    const MeterSegment& segment = m_meters[(size_t)findSegment(m_meters, &MeterSegment::measure, measure)];
+    return segment.tick + (measure - segment.measure) * segment.ticksPerMeasure;
+}
+
+juce::uint32 TempoMap::getHash() const
+{
+    //FNV-1a over the changes
+    juce::uint32 hash = 2166136261u;
+    auto add = [&hash](double value)
+    {
+        juce::uint64 bits;
+        std::memcpy(&bits, &value, sizeof(double));
+        for (int i = 0; i < 8; i++)
+            hash = (hash ^ (juce::uint32)((bits >> (8 * i)) & 0xff)) * 16777619u;
+    };
+    for (const TempoSegment& segment : m_tempos)
+    {
+        add(segment.tick);
+        add(segment.bpm);
+    }
+    for (const MeterSegment& segment : m_meters)
+    {
+        add(segment.tick);
+        add(segment.numerator);
+        add(segment.denominator);
+    }
+    return hash;
+}
+
+//==============================================================================
+
+BenchmarkResult TempoMap::benchmark(int numChanges)
+{
+    //a tempo change every few beats like a long ritardando, and a meter change every few measures
+    juce::Random random(numChanges);
+    TempoMap tempoMap;
+    double tick = 0;
+    for (int i = 0; i < numChanges; i++)
+    {
+        tempoMap.addTempoChange(tick, 60 + random.nextDouble() * 120);
+        if (i % 4 == 0)
+            tempoMap.addMeterChange(tick, 3 + random.nextInt(5), random.nextBool() ? 4 : 8);
+        tick += g_defaultQuarterNoteTicks * (1 + random.nextInt(8));
+    }
+
+    const int numValues = 1000000;
+    std::vector<double> ticks((size_t)numValues);
+    for (double& value : ticks)
+        value = random.nextDouble() * tick * 1.1;
+    std::sort(ticks.begin(), ticks.end());
+
+    juce::String output = "TempoMap::benchmark " + juce::String(numChanges) + " tempo changes, " + juce::String(numValues) + " ticks\n";
+
+    //walking from the first change, how a single constant bpm map would have to be extended
+    TimerBench timerBench;
+    std::vector<double> walkedMS((size_t)juce::jmin(numValues, 10000));
+    for (size_t i = 0; i < walkedMS.size(); i++)
+    {
+        double ms = 0;
+        size_t segment = 0;
+        for (; segment + 1 < tempoMap.m_tempos.size() && tempoMap.m_tempos[segment + 1].tick <= ticks[i * (numValues / walkedMS.size())]; segment++)
+            ms += (tempoMap.m_tempos[segment + 1].tick - tempoMap.m_tempos[segment].tick) * tempoMap.m_tempos[segment].msPerTick;
+        walkedMS[i] = ms + (ticks[i * (numValues / walkedMS.size())] - tempoMap.m_tempos[segment].tick) * tempoMap.m_tempos[segment].msPerTick;
+    }
+    output += timerBench.StopAndGetTime("walk of " + juce::String((int)walkedMS.size()) + " ticks (us)") + "\n";
+
+    timerBench.Start();
+    std::vector<double> searchedMS((size_t)numValues);
+    for (int i = 0; i < numValues; i++)
+        searchedMS[(size_t)i] = tempoMap.tickToMS(ticks[(size_t)i]);
+    output += timerBench.StopAndGetTime("tickToMS (us)") + "\n";
+
+    timerBench.Start();
+    std::vector<double> mergedMS((size_t)numValues);
+    tempoMap.ticksToMS(ticks.data(), mergedMS.data(), numValues);
+    output += timerBench.StopAndGetTime("ticksToMS (us)") + "\n";
+
+    timerBench.Start();
+    std::vector<double> roundTrip((size_t)numValues);
+    tempoMap.msToTicks(mergedMS.data(), roundTrip.data(), numValues);
+    output += timerBench.StopAndGetTime("msToTicks (us)") + "\n";
+
+    //the sums are added in another order, so they only agree to a tiny fraction of a ms
+    auto differs = [](double a, double b) { return std::abs(a - b) > 1e-6 * juce::jmax(1.0, std::abs(a)); };
+    int mismatches = 0;
+    for (size_t i = 0; i < walkedMS.size(); i++)
+        mismatches += differs(walkedMS[i], searchedMS[i * (numValues / walkedMS.size())]) ? 1 : 0;
+    for (int i = 0; i < numValues; i++)
+    {
+        mismatches += differs(searchedMS[(size_t)i], mergedMS[(size_t)i]) ? 1 : 0;
+        mismatches += differs(ticks[(size_t)i], roundTrip[(size_t)i]) ? 1 : 0;
+        double measure = tempoMap.tickToMeasure(ticks[(size_t)i]);
+        mismatches += differs(ticks[(size_t)i], tempoMap.measureToTick(measure)) ? 1 : 0;
+    }
+    output += "mismatches: " + juce::String(mismatches) + "\n";
+    return { output, mismatches };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Globals.h"
+#include <vector>
+
+//==============================================================================
+//tempo and meter changes as segments that know the ms and measure they start at, so a tick or ms is converted
+//with a binary search over the segments instead of a walk from the start. Ticks are normalized to
+//g_defaultQuarterNoteTicks, ms and measures are absolute from tick 0. Before the first change the first tempo
+//and meter go on backwards
+class TempoMap
+{
+public:
+    //one tempo and meter from the start
+    TempoMap(double bpm = 120, int numerator = 4, int denominator = 4);
+
+    //the tempo and time signature meta events of every track, bpm and 4/4 until the first of them
+    static TempoMap fromMidiFile(const juce::MidiFile& midiFile, double bpm);
+
+    //changes can be added in any order, a change at the same tick as an earlier one replaces it
+    void addTempoChange(double tick, double bpm);
+    void addMeterChange(double tick, int numerator, int denominator);
+
+    //false for one tempo and meter, those are converted the same way with a constant bpm and numerator
+    bool hasChanges() const { return m_tempos.size() > 1 || m_meters.size() > 1; }
+    int getNumTempoChanges() const { return (int)m_tempos.size(); }
+    int getNumMeterChanges() const { return (int)m_meters.size(); }
+
+    double getBpm(double tick) const;
+    juce::AudioPlayHead::TimeSignature getTimeSignature(double tick) const;
+
+    double tickToMS(double tick) const;
+    double msToTick(double ms) const;
+    //for sorted ticks or ms, one merge over the segments instead of a search for every value. in and out can be the same
+    void ticksToMS(const double* ticks, double* ms, int numValues) const;
+    void msToTicks(const double* ms, double* ticks, int numValues) const;
+
+    //measure 0 starts at tick 0, the fraction is the position in the measure
+    double tickToMeasure(double tick) const;
+    double measureToTick(double measure) const;
+
+    //the same for maps with the same changes, for files that keep results of a map
+    juce::uint32 getHash() const;
+
+    //times the binary search and the merge against walking every segment from the start on a map with numChanges
+    //tempo changes, every conversion where they disagree fails
+    static BenchmarkResult benchmark(int numChanges);
+
+private:
+    struct TempoSegment
+    {
+        double tick = 0;
+        double ms = 0;
+        double msPerTick = 0;
+        double bpm = 120;
+    };
+    struct MeterSegment
+    {
+        double tick = 0;
+        double measure = 0;
+        double ticksPerMeasure = 0;
+        int numerator = 4;
+        int denominator = 4;
+    };
+
+    //the prefix sums of ms or measures at the start of every segment from first on, so changes that are added in
+    //order only update the last segment
+    void updateTempoSegments(size_t first);
+    void updateMeterSegments(size_t first);
+    //the segment that tick is in, the first one for ticks before it
+    template <typename Segment, typename Value>
+    static int findSegment(const std::vector<Segment>& segments, Value Segment::* key, double value);
+
+    std::vector<TempoSegment> m_tempos;
+    std::vector<MeterSegment> m_meters;
+};
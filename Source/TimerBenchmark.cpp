@@ -69,3 +69,28 @@ juce::String TimerBench::formatTime(long long time)
 
     return output;
 }
+
+//==============================================================================
+
+std::vector<BenchmarkHits::Hit> BenchmarkHits::generate(float* samples, juce::int64 numSamples, juce::Random& random) const
+{
+    std::vector<Hit> hits;
+    juce::int64 nextHit = firstHit;
+    float hitGain = 0;
+    float decay = decayPerSample;
+    for (juce::int64 i = 0; i < numSamples; i++)
+    {
+        if (i == nextHit)
+        {
+            float gainBefore = hitGain;
+            hitGain = minGain + random.nextFloat() * (maxGain - minGain);
+            hits.push_back({ i, hitGain, gainBefore });
+            if (maxDecaySeconds > 0)
+                decay = std::pow(0.001f, 1.f / (float)(sampleRate * (minDecaySeconds + random.nextDouble() * (maxDecaySeconds - minDecaySeconds))));
+            nextHit += (juce::int64)(sampleRate * (minSecondsApart + random.nextDouble() * (maxSecondsApart - minSecondsApart)));
+        }
+        hitGain *= decay;
+        samples[i] = hitGain * (random.nextFloat() * 2 - 1) + (random.nextFloat() - 0.5f) * 0.002f;
+    }
+    return hits;
+}
@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include <chrono>
+#include <vector>
 
 class TimerBench
 {
@@ -24,4 +25,40 @@ private:
 
 private:
     JUCE_LEAK_DETECTOR(TimerBench)
-};
\ No newline at end of file
+};
+
+//what a benchmark prints and how many of its checks failed, the command line exits with an error if any did
+struct BenchmarkResult
+{
+    juce::String report;
+    int numFailed = 0;
+};
+
+//decaying hits of noise over quiet noise like a drum take, for the benchmarks of the audio detectors. The defaults are
+//the hits of AudioHitDetector::benchmark
+struct BenchmarkHits
+{
+    double sampleRate = 48000;
+    //sample of the first hit and the range of the time from one hit to the next
+    juce::int64 firstHit = 0;
+    double minSecondsApart = 0.1;
+    double maxSecondsApart = 0.4;
+    float minGain = 0.2f;
+    float maxGain = 1;
+    //a hit gets quieter by decayPerSample every sample, or fades to -60 dB in minDecaySeconds to maxDecaySeconds
+    //when maxDecaySeconds is set
+    float decayPerSample = 0.999f;
+    double minDecaySeconds = 0;
+    double maxDecaySeconds = 0;
+
+    struct Hit
+    {
+        juce::int64 sample = 0;
+        float gain = 0;
+        //what was left of the hits before, a hit that isn't clearly louder is buried in their decay
+        float gainBefore = 0;
+    };
+
+    //fills the samples and returns every hit
+    std::vector<Hit> generate(float* samples, juce::int64 numSamples, juce::Random& random) const;
+};
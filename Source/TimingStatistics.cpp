@@ -0,0 +1,193 @@
+#include "TimingStatistics.h"
+#include <algorithm>
+
+//==============================================================================
+
+void TDigest::add(double value, double weight)
+{
+    if (m_totalWeight == 0)
+    {
+        m_min = value;
+        m_max = value;
+    }
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_totalWeight += weight;
+
+    m_buffer.push_back({ value, weight });
+    if (m_buffer.size() > 5 * m_compression)
+        compress();
+}
+
+void TDigest::merge(const TDigest& other)
+{
+    if (other.m_totalWeight == 0)
+        return;
+
+    if (m_totalWeight == 0)
+    {
+        m_min = other.m_min;
+        m_max = other.m_max;
+    }
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_totalWeight += other.m_totalWeight;
+
+    m_buffer.insert(m_buffer.end(), other.m_centroids.begin(), other.m_centroids.end());
+    m_buffer.insert(m_buffer.end(), other.m_buffer.begin(), other.m_buffer.end());
+    compress();
+}
+
+void TDigest::clear()
+{
+    m_totalWeight = 0;
+    m_centroids.clear();
+    m_buffer.clear();
+}
+
+void TDigest::compress() const
+{
+    if (m_buffer.empty())
+        return;
+
+    m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+    std::sort(m_buffer.begin(), m_buffer.end(), [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    //a centroid may only grow to 4 * W * q * (1 - q) / compression, so the tails stay exact
+    m_centroids.clear();
+    double weightSoFar = 0;
+    Centroid current = m_buffer.front();
+    for (size_t i = 1; i < m_buffer.size(); i++)
+    {
+        double proposedWeight = current.weight + m_buffer[i].weight;
+        double q0 = weightSoFar / m_totalWeight;
+        double q2 = (weightSoFar + proposedWeight) / m_totalWeight;
+        double weightLimit = 4 * m_totalWeight * std::min(q0 * (1 - q0), q2 * (1 - q2)) / m_compression;
+
+        if (proposedWeight <= weightLimit)
+        {
+            current.mean += (m_buffer[i].mean - current.mean) * m_buffer[i].weight / proposedWeight;
+            current.weight = proposedWeight;
+        }
+        else
+        {
+            weightSoFar += current.weight;
+            m_centroids.push_back(current);
+            current = m_buffer[i];
+        }
+    }
+    m_centroids.push_back(current);
+    m_buffer.clear();
+}
+
+double TDigest::getQuantile(double q) const
+{
+    compress();
+    if (m_centroids.empty())
+        return 0;
+    if (m_centroids.size() == 1)
+        return m_centroids.front().mean;
+
+    //interpolate between the centers of neighbouring centroids, the ends interpolate to the min and max
+    double index = juce::jlimit(0.0, 1.0, q) * m_totalWeight;
+    double previousCenter = 0;
+    double previousMean = m_min;
+    double weightSoFar = 0;
+    for (const Centroid& centroid : m_centroids)
+    {
+        double center = weightSoFar + centroid.weight / 2;
+        if (index < center)
+            return previousMean + (centroid.mean - previousMean) * (index - previousCenter) / (center - previousCenter);
+
+        previousCenter = center;
+        previousMean = centroid.mean;
+        weightSoFar += centroid.weight;
+    }
+
+    if (m_totalWeight <= previousCenter)
+        return m_max;
+    return previousMean + (m_max - previousMean) * (index - previousCenter) / (m_totalWeight - previousCenter);
+}
+
+//==============================================================================
+
+void TimingSummary::add(double msDeviation, bool onTime)
+{
+    count++;
+    if (onTime)
+        onTimeCount++;
+
+    double delta = msDeviation - mean;
+    mean += delta / count;
+    m2 += delta * (msDeviation - mean);
+
+    sumAbsoluteDeviation += std::abs(msDeviation);
+    absoluteDeviations.add(std::abs(msDeviation));
+}
+
+void TimingSummary::merge(const TimingSummary& other)
+{
+    if (other.count == 0)
+        return;
+
+    //parallel Welford
+    int newCount = count + other.count;
+    double delta = other.mean - mean;
+    m2 += other.m2 + delta * delta * ((double)count * other.count / newCount);
+    mean += delta * other.count / newCount;
+
+    count = newCount;
+    onTimeCount += other.onTimeCount;
+    sumAbsoluteDeviation += other.sumAbsoluteDeviation;
+    absoluteDeviations.merge(other.absoluteDeviations);
+}
+
+juce::String TimingSummary::toString() const
+{
+    if (count == 0)
+        return "no hits";
+
+    auto ms = [](double value) { return juce::String(value, 1); };
+
+    juce::String output;
+    output += "hits: " + juce::String(count);
+    output += ", on time: " + juce::String(juce::roundToInt(getOnTimeRatio() * 100)) + "%";
+    output += ", mean: " + juce::String(mean >= 0 ? "+" : "") + ms(mean) + " ms";
+    output += ", mean abs: " + ms(getMeanAbsoluteDeviation()) + " ms";
+    output += ", sd: " + ms(getStandardDeviation()) + " ms";
+    output += ", p50/p90/p99: " + ms(getAbsolutePercentile(0.5)) + "/" + ms(getAbsolutePercentile(0.9)) + "/" + ms(getAbsolutePercentile(0.99)) + " ms";
+    return output;
+}
+
+//==============================================================================
+
+void TimingStatistics::clear()
+{
+    total = TimingSummary();
+    byPitch.clear();
+    byMeasure.clear();
+}
+
+void TimingStatistics::add(int note, int measure, double msDeviation, bool onTime)
+{
+    byPitch[note].add(msDeviation, onTime);
+    byMeasure[measure].add(msDeviation, onTime);
+}
+
+void TimingStatistics::finish()
+{
+    total = TimingSummary();
+    for (auto& [measure, summary] : byMeasure)
+        total.merge(summary);
+}
+
+juce::String TimingStatistics::debugTimingStatistics() const
+{
+    juce::String output = "TimingStatistics:\n";
+    output += "total: " + total.toString() + "\n";
+    for (auto& [note, summary] : byPitch)
+        output += "note " + juce::String(note) + ": " + summary.toString() + "\n";
+    for (auto& [measure, summary] : byMeasure)
+        output += "measure " + juce::String(measure) + ": " + summary.toString() + "\n";
+    return output;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Globals.h"
+#include <map>
+#include <vector>
+
+//==============================================================================
+//mergeable percentile sketch (merging t-digest), percentiles of merged digests roll up without the original values
+class TDigest
+{
+public:
+    TDigest(double compression = 100) : m_compression(compression) {}
+
+    void add(double value, double weight = 1);
+    void merge(const TDigest& other);
+    void clear();
+
+    //q from 0 to 1
+    double getQuantile(double q) const;
+    double getCount() const { return m_totalWeight; }
+
+private:
+    struct Centroid
+    {
+        double mean = 0;
+        double weight = 0;
+    };
+
+    //merges the buffered values into the centroids
+    void compress() const;
+
+    double m_compression;
+    double m_totalWeight = 0;
+    double m_min = 0;
+    double m_max = 0;
+    mutable std::vector<Centroid> m_centroids;
+    mutable std::vector<Centroid> m_buffer;
+};
+
+//==============================================================================
+//timing of a group of matched hits, deviations are in ms and positive when late
+struct TimingSummary
+{
+    void add(double msDeviation, bool onTime);
+    void merge(const TimingSummary& other);
+
+    double getStandardDeviation() const { return count > 1 ? std::sqrt(m2 / (count - 1)) : 0; }
+    double getOnTimeRatio() const { return count > 0 ? (double)onTimeCount / count : 0; }
+    double getMeanAbsoluteDeviation() const { return count > 0 ? sumAbsoluteDeviation / count : 0; }
+    //percentile of the absolute deviation, q from 0 to 1
+    double getAbsolutePercentile(double q) const { return absoluteDeviations.getQuantile(q); }
+
+    juce::String toString() const;
+
+    int count = 0;
+    int onTimeCount = 0;
+    //signed, running mean and sum of squared differences (Welford)
+    double mean = 0;
+    double m2 = 0;
+    double sumAbsoluteDeviation = 0;
+    TDigest absoluteDeviations;
+};
+
+//==============================================================================
+//timing of a take per pitch and per measure, collected in one pass over the matched hits
+class TimingStatistics
+{
+public:
+    TimingStatistics() {}
+
+    void clear();
+    void add(int note, int measure, double msDeviation, bool onTime);
+    //rolls the measures up into the total, call after the last add
+    void finish();
+
+    bool isEmpty() const { return total.count == 0; }
+    juce::String debugTimingStatistics() const;
+
+    TimingSummary total;
+    std::map<int, TimingSummary> byPitch;
+    std::map<int, TimingSummary> byMeasure;
+
+private:
+    JUCE_LEAK_DETECTOR(TimingStatistics)
+};
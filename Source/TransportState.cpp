@@ -0,0 +1,38 @@
+#include "TransportState.h"
+
+void TransportState::update(const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
+{
+    numBlocks++;
+    bool wasRecording = isRecording;
+    if (!position.hasValue())
+    {
+        hasPpqPosition = false;
+        timeInSamples = -1;
+        isPlaying = false;
+        isRecording = false;
+        return;
+    }
+
+    bpm = position->getBpm().orFallback(bpm);
+    timeSignature = position->getTimeSignature().orFallback(timeSignature);
+    hasPpqPosition = position->getPpqPosition().hasValue();
+    ppqPosition = position->getPpqPosition().orFallback(ppqPosition);
+    ppqPositionOfLastBarStart = position->getPpqPositionOfLastBarStart().orFallback(ppqPositionOfLastBarStart);
+    timeInSamples = position->getTimeInSamples().orFallback(-1);
+
+    isPlaying = position->getIsPlaying();
+    isRecording = position->getIsRecording();
+    isLooping = position->getIsLooping();
+    auto loopPoints = position->getLoopPoints();
+    if (loopPoints.hasValue())
+    {
+        loopStartPpq = loopPoints->ppqStart;
+        loopEndPpq = loopPoints->ppqEnd;
+    }
+
+    if (isRecording && !wasRecording && hasPpqPosition)
+    {
+        recordStartPpq = ppqPosition;
+        numRecordStarts++;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Globals.h"
+
+//==============================================================================
+//the host position of one block. The audio thread reads the play head once per block into it and publishes a copy,
+//so the editor never calls the play head or reads fields that the audio thread is writing
+struct TransportState
+{
+    //takes the values the host gave, the others keep the value of the previous block
+    void update(const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+
+    //blocks processed so far, 0 until the host calls processBlock
+    juce::int64 numBlocks = 0;
+    double bpm = 120;
+    juce::AudioPlayHead::TimeSignature timeSignature;
+    //quarter note position of the block start, only valid with hasPpqPosition
+    double ppqPosition = 0;
+    bool hasPpqPosition = false;
+    double ppqPositionOfLastBarStart = 0;
+    //host position in samples, -1 if the host doesn't give it
+    juce::int64 timeInSamples = -1;
+
+    bool isPlaying = false;
+    bool isRecording = false;
+    bool isLooping = false;
+    double loopStartPpq = 0;
+    double loopEndPpq = 0;
+
+    //ppq position of the block where the host last started recording, counted so the same position is a new record-in too
+    double recordStartPpq = 0;
+    int numRecordStarts = 0;
+};